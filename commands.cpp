@@ -0,0 +1,198 @@
+#include "linetype.h"      // Our line and shape code
+#include <iostream>        // For input/output
+#include <iomanip>        // For 3 decimal places in answers
+#include <sstream>        // For collecting answers before sending them
+#include <string>         // For text manipulation
+#include <vector>         // For storing our sets
+#include <cmath>          // For isinf
+#include <cctype>         // For tolower and isdigit
+
+using namespace std;      // So we don't have to write std:: all the time
+
+// Splits a query into lowercase words
+static vector<string> splitWords(const string& command) {
+    vector<string> words;
+    stringstream ss(command);
+    string word;
+    while (ss >> word) {
+        for (char& ch : word) {
+            ch = static_cast<char>(tolower(static_cast<unsigned char>(ch)));
+        }
+        words.push_back(word);
+    }
+    return words;
+}
+
+// Reads a number like "3" or "l3" from words[pos], 0 if there isn't one there
+static int readNumber(const vector<string>& words, size_t pos) {
+    if (pos >= words.size()) return 0;
+    string word = words[pos];
+    if (!word.empty() && word[0] == 'l') word = word.substr(1);
+    if (word.empty() || word.size() > 9) return 0;
+    for (char ch : word) {
+        if (!isdigit(static_cast<unsigned char>(ch))) return 0;
+    }
+    return stoi(word);
+}
+
+// Works out which set a query is about: "set N", just "N", or the set picked with "use set N".
+// Moves pos past whatever it read, returns -1 if there's no good set.
+static int readSet(const vector<string>& words, size_t& pos, const vector<lineSet>& sets,
+    const commandSession& session, bool allowBareNumber) {
+    int number = 0;
+    if (pos < words.size() && words[pos] == "set") {
+        number = readNumber(words, pos + 1);
+        pos += 2;
+    }
+    else if (allowBareNumber && readNumber(words, pos) > 0) {
+        number = readNumber(words, pos);
+        pos += 1;
+    }
+    else {
+        return session.currentSet;
+    }
+    if (number < 1 || number > static_cast<int>(sets.size())) return -1;
+    return number - 1;
+}
+
+// Sends a block of text as "ok lines N" followed by its N lines
+static void answerBlock(ostream& out, const string& text) {
+    int count = 0;
+    for (char ch : text) {
+        if (ch == '\n') count++;
+    }
+    out << "ok lines " << count << "\n" << text;
+}
+
+// Answers one query, returns false when the query was "quit"
+bool runCommand(const string& command, const vector<lineSet>& sets,
+    commandSession& session, ostream& out) {
+    vector<string> words = splitWords(command);
+    if (words.empty() || words[0][0] == '#') return true;    // Blank lines and comments get no answer
+
+    out << fixed << setprecision(3);
+    const string& verb = words[0];
+    size_t pos = 1;
+
+    if (verb == "quit" || verb == "exit") {
+        out << "ok bye\n";
+        return false;
+    }
+    if (verb == "help") {
+        out << "ok commands: sets, use set N, classify [set N], relations [set N], "
+            << "intersect [set N] L1 L2, lines [set N], render [set N], metrics [set N], stats, quit\n";
+        return true;
+    }
+    if (verb == "sets") {
+        out << "ok " << sets.size() << " sets\n";
+        return true;
+    }
+    if (verb == "stats") {
+        predicateCounters counters = getPredicateCounters();
+        const char* modes[] = { "epsilon", "adaptive", "exact" };
+        out << "ok mode " << modes[static_cast<int>(getPrecisionMode())]
+            << " fast " << counters.fastPath << " exact " << counters.exactPath << "\n";
+        return true;
+    }
+
+    // Everything else is about one set
+    bool knownVerb = verb == "use" || verb == "classify" || verb == "relations" ||
+        verb == "intersect" || verb == "lines" || verb == "render" || verb == "metrics";
+    if (!knownVerb) {
+        out << "error unknown command: " << verb << "\n";
+        return true;
+    }
+    int setIndex = readSet(words, pos, sets, session, verb != "intersect");
+    if (setIndex < 0) {
+        out << "error pick a set from 1 to " << sets.size() << " (\"" << verb << " set N\" or \"use set N\")\n";
+        return true;
+    }
+    const lineSet& set = sets[setIndex];
+
+    if (verb == "use") {
+        session.currentSet = setIndex;
+        out << "ok using set " << (setIndex + 1) << "\n";
+    }
+    else if (verb == "classify") {
+        const shapeReport& report = set.classification();
+        out << "ok " << shapeName(report.type);
+        if (!report.sideLengths.empty()) {
+            out << " sides";
+            for (double length : report.sideLengths) {
+                out << " " << length;
+            }
+        }
+        out << "\n";
+    }
+    else if (verb == "relations") {
+        string parallel, perpendicular;
+        for (int i = 0; i < set.size(); i++) {
+            for (int j = i + 1; j < set.size(); j++) {
+                string pair = " " + to_string(i + 1) + "-" + to_string(j + 1);
+                if (set.isParallel(i, j)) parallel += pair;
+                if (set.isPerpendicular(i, j)) perpendicular += pair;
+            }
+        }
+        out << "ok parallel" << (parallel.empty() ? " none" : parallel)
+            << " perpendicular" << (perpendicular.empty() ? " none" : perpendicular) << "\n";
+    }
+    else if (verb == "intersect") {
+        int line1 = readNumber(words, pos);
+        int line2 = readNumber(words, pos + 1);
+        if (line1 < 1 || line1 > set.size() || line2 < 1 || line2 > set.size() || line1 == line2) {
+            out << "error intersect needs two different lines from 1 to " << set.size() << "\n";
+            return true;
+        }
+        Point p = set.intersection(line1 - 1, line2 - 1);
+        if (isinf(p.x) || isinf(p.y)) {
+            out << "ok parallel\n";
+        }
+        else {
+            out << "ok " << p.x << " " << p.y << "\n";
+        }
+    }
+    else if (verb == "lines") {
+        ostringstream text;
+        text << setprecision(17);
+        for (int i = 0; i < set.size(); i++) {
+            text << set.line(i).getA() << " " << set.line(i).getB() << " " << set.line(i).getC() << "\n";
+        }
+        answerBlock(out, text.str());
+    }
+    else if (verb == "metrics") {
+        out << "ok ";
+        printMetrics(measureSet(set), out);
+        out << "\n";
+    }
+    else {    // render
+        ostringstream text;
+        displayVisualization(set.relations(), set.positions(), text);
+        answerBlock(out, text.str());
+    }
+    return true;
+}
+
+// Reads queries until the input ends (or "quit"). Answers are saved up and sent together
+// whenever we've caught up with all the input that's already waiting, so a script that
+// sends a pile of queries at once gets one write back instead of one per query.
+void runCommandMode(istream& in, ostream& out, const vector<vector<lineType>>& allLines) {
+    // Analyze every set once up front, after that each query is just a lookup
+    vector<lineSet> sets;
+    for (const vector<lineType>& lines : allLines) {
+        sets.push_back(lineSet(lines));
+    }
+
+    const streamoff MAX_BATCH = 1 << 16;
+    commandSession session;
+    ostringstream batch;
+    string command;
+    bool running = true;
+    while (running && getline(in, command)) {
+        running = runCommand(command, sets, session, batch);
+        if (in.rdbuf()->in_avail() <= 0 || batch.tellp() > MAX_BATCH) {
+            out << batch.str() << flush;
+            batch.str("");
+        }
+    }
+    out << batch.str() << flush;
+}
@@ -0,0 +1,533 @@
+#include "linetype.h"      // The code we're checking
+#include <random>          // For making up random lines
+#include <cmath>           // For isinf, isnan, ldexp
+#include <algorithm>       // For sort and swap
+#include <limits>          // For infinity
+#include <iostream>        // For printing what went wrong
+#include <iomanip>        // For printing every digit of a failing case
+#include <sstream>        // For building failure messages
+#include <string>         // For text manipulation
+#include <vector>         // For storing lists of lines
+#include <chrono>         // For timing the run
+
+using namespace std;      // So we don't have to write std:: all the time
+
+// One thing to check: a set of 4 lines, plus an edit to try on a lineSet made from them
+struct fuzzCase {
+    vector<lineType> lines;
+    int editKind;          // 0 = replace, 1 = insert then remove another, 2 = remove then insert
+    int editIndex;         // Which position the edit happens at
+    lineType edit;         // The line the edit puts in
+};
+
+// The original checkQuadrilateral, straight from the lines with no caching at all.
+// This is the slow answer everything fast gets compared against, so don't "improve" it.
+static shapeReport referenceClassify(const vector<lineType>& lines) {
+    shapeReport report;
+    if (lines.size() != 4) return report;
+
+    vector<Point> allIntersections;
+    for (size_t i = 0; i < lines.size(); ++i) {
+        for (size_t j = i + 1; j < lines.size(); ++j) {
+            Point p = lines[i].findIntersectionPoint(lines[j]);
+            if (!isinf(p.x) && !isinf(p.y)) {
+                allIntersections.push_back(p);
+            }
+        }
+    }
+
+    vector<Point> orderedPoints;
+    if (allIntersections.size() >= 4) {
+        int topmost = 0;
+        for (size_t i = 1; i < allIntersections.size(); i++) {
+            if (allIntersections[i].y > allIntersections[topmost].y) {
+                topmost = i;
+            }
+        }
+        orderedPoints.push_back(allIntersections[topmost]);
+
+        vector<bool> used(allIntersections.size(), false);
+        used[topmost] = true;
+
+        for (int i = 0; i < 3; i++) {
+            double minDist = numeric_limits<double>::max();
+            int nextPoint = -1;
+
+            for (size_t j = 0; j < allIntersections.size(); j++) {
+                if (!used[j]) {
+                    double dist = calculateDistance(orderedPoints.back(), allIntersections[j]);
+                    if (dist < minDist) {
+                        minDist = dist;
+                        nextPoint = j;
+                    }
+                }
+            }
+
+            if (nextPoint != -1) {
+                orderedPoints.push_back(allIntersections[nextPoint]);
+                used[nextPoint] = true;
+            }
+        }
+    }
+
+    vector<double> sideLengths;
+    if (orderedPoints.size() == 4) {
+        sideLengths.push_back(calculateDistance(orderedPoints[0], orderedPoints[1]));
+        sideLengths.push_back(calculateDistance(orderedPoints[1], orderedPoints[2]));
+        sideLengths.push_back(calculateDistance(orderedPoints[2], orderedPoints[3]));
+        sideLengths.push_back(calculateDistance(orderedPoints[3], orderedPoints[0]));
+    }
+    report.sideLengths = sideLengths;
+    sort(sideLengths.begin(), sideLengths.end());
+
+    vector<lineType> reorderedLines = lines;
+    if (!lines[0].isParallel(lines[2])) {
+        swap(reorderedLines[1], reorderedLines[2]);
+    }
+
+    bool equalSides = (sideLengths.size() == 4) &&
+        (abs(sideLengths[0] - sideLengths[3]) < 1e-9);
+
+    bool equalOpposites = (sideLengths.size() == 4) &&
+        (abs(sideLengths[0] - sideLengths[1]) < 1e-9) &&
+        (abs(sideLengths[2] - sideLengths[3]) < 1e-9);
+
+    bool isParallelogram = reorderedLines[0].isParallel(reorderedLines[2]) &&
+        reorderedLines[1].isParallel(reorderedLines[3]);
+
+    bool isRectangle = reorderedLines[0].isPerpendicular(reorderedLines[1]) &&
+        reorderedLines[1].isPerpendicular(reorderedLines[2]) &&
+        reorderedLines[2].isPerpendicular(reorderedLines[3]) &&
+        reorderedLines[3].isPerpendicular(reorderedLines[0]) &&
+        isParallelogram &&
+        equalOpposites;
+
+    bool isRhombus = reorderedLines[0].isParallel(reorderedLines[2]) &&
+        reorderedLines[1].isParallel(reorderedLines[3]) &&
+        equalSides;
+
+    bool isSquare = reorderedLines[0].isPerpendicular(reorderedLines[1]) &&
+        reorderedLines[1].isPerpendicular(reorderedLines[2]) &&
+        reorderedLines[2].isPerpendicular(reorderedLines[3]) &&
+        reorderedLines[3].isPerpendicular(reorderedLines[0]) &&
+        isParallelogram &&
+        equalSides;
+
+    bool isTrapezoid = (reorderedLines[0].isParallel(reorderedLines[2]) &&
+        !reorderedLines[1].isParallel(reorderedLines[3])) ||
+        (reorderedLines[1].isParallel(reorderedLines[3]) &&
+            !reorderedLines[0].isParallel(reorderedLines[2]));
+
+    if (isSquare) report.type = shapeType::Square;
+    else if (isRectangle) report.type = shapeType::Rectangle;
+    else if (isRhombus) report.type = shapeType::Rhombus;
+    else if (isParallelogram) report.type = shapeType::Parallelogram;
+    else if (isTrapezoid) report.type = shapeType::Trapezoid;
+    else report.type = shapeType::Irregular;
+    return report;
+}
+
+// Two points are the same if every digit matches (two NaNs count as the same too)
+static bool sameNumber(double a, double b) {
+    return a == b || (isnan(a) && isnan(b));
+}
+
+static bool samePoint(const Point& p, const Point& q) {
+    return sameNumber(p.x, q.x) && sameNumber(p.y, q.y);
+}
+
+static bool sameReport(const shapeReport& r1, const shapeReport& r2) {
+    if (r1.type != r2.type || r1.sideLengths.size() != r2.sideLengths.size()) return false;
+    for (size_t i = 0; i < r1.sideLengths.size(); i++) {
+        if (r1.sideLengths[i] != r2.sideLengths[i] &&
+            !(isnan(r1.sideLengths[i]) && isnan(r2.sideLengths[i]))) return false;
+    }
+    return true;
+}
+
+// Cached relations must say exactly what asking the lines directly says
+static string checkRelations(const vector<lineType>& lines, const lineRelations& relations,
+    const vector<int>& order, const string& name) {
+    for (size_t i = 0; i < lines.size(); i++) {
+        for (size_t j = 0; j < lines.size(); j++) {
+            if (i == j) continue;
+            int ri = order[i], rj = order[j];
+            if (relations.isParallel(ri, rj) != lines[i].isParallel(lines[j])) {
+                return name + ": parallel(" + to_string(i + 1) + "," + to_string(j + 1) + ") differs";
+            }
+            if (relations.isPerpendicular(ri, rj) != lines[i].isPerpendicular(lines[j])) {
+                return name + ": perpendicular(" + to_string(i + 1) + "," + to_string(j + 1) + ") differs";
+            }
+            if (!samePoint(relations.intersection(ri, rj), lines[i].findIntersectionPoint(lines[j]))) {
+                return name + ": intersection(" + to_string(i + 1) + "," + to_string(j + 1) + ") differs";
+            }
+        }
+    }
+    return "";
+}
+
+// Checks the metrics of a set. For a parallelogram the area comes straight from the line equations
+// without finding any corners: the gap between each parallel pair, multiplied together, over how far
+// from parallel the two pairs are. Every shape we do measure must also be convex, so its angles
+// are all at most 180 and add up to 360.
+static string checkMetrics(const vector<lineType>& lines, const lineSet& set) {
+    polygonMetrics metrics = measureSet(set);
+    if (metrics.valid) {
+        double total = 0;
+        for (double angle : metrics.angles) {
+            if (!(angle >= 0 && angle <= 180 + 1e-9)) return "measureSet gave an angle outside 0 to 180";
+            total += angle;
+        }
+        if (abs(total - 360) > 1e-6) return "measureSet angles don't add up to 360";
+    }
+
+    // Opposite pairs to try: 1,2 with 3,4, then 1,3 with 2,4, then 1,4 with 2,3
+    const int pairings[3][4] = { { 0, 1, 2, 3 }, { 0, 2, 1, 3 }, { 0, 3, 1, 2 } };
+    for (const int* pair : pairings) {
+        const lineType& p = lines[pair[0]];
+        const lineType& q = lines[pair[1]];
+        const lineType& r = lines[pair[2]];
+        const lineType& s = lines[pair[3]];
+        if (!set.isParallel(pair[0], pair[1]) || !set.isParallel(pair[2], pair[3]) || set.isParallel(pair[0], pair[2])) continue;
+
+        // Only exact multiples, nearly parallel lines don't make a real parallelogram to compare with
+        if (p.getA() * q.getB() != q.getA() * p.getB() || r.getA() * s.getB() != s.getA() * r.getB()) continue;
+        double scale1 = abs(p.getA()) > abs(p.getB()) ? q.getA() / p.getA() : q.getB() / p.getB();
+        double scale2 = abs(r.getA()) > abs(r.getB()) ? s.getA() / r.getA() : s.getB() / r.getB();
+        double gap1 = p.getC() - q.getC() / scale1;
+        double gap2 = r.getC() - s.getC() / scale2;
+        double det = p.getA() * r.getB() - r.getA() * p.getB();
+
+        // A scaled copy of the same line leaves a gap that's only rounding, the sides lie on top of each other
+        if (!(abs(gap1) > 1e-9 * max(abs(p.getC()), abs(q.getC() / scale1))) ||
+            !(abs(gap2) > 1e-9 * max(abs(r.getC()), abs(s.getC() / scale2)))) continue;
+
+        // Epsilon mode has its own cutoff for crossing, so sides it calls not parallel can still miss
+        bool allCross = true;
+        vector<Point> corners;
+        for (int k = 0; k < 2; k++) {
+            for (int m = 2; m < 4; m++) {
+                corners.push_back(set.intersection(pair[k], pair[m]));
+                if (!isfinite(corners.back().x) || !isfinite(corners.back().y)) allCross = false;
+            }
+        }
+        if (!allCross) return "";
+        double widest = 0;
+        for (const Point& c1 : corners) {
+            for (const Point& c2 : corners) {
+                widest = max(widest, hypot(c1.x - c2.x, c1.y - c2.y));
+            }
+        }
+
+        // Skip pairs that are so close to parallel that the corners themselves can't be trusted
+        double sine = abs(det) / (hypot(p.getA(), p.getB()) * hypot(r.getA(), r.getB()));
+        double expected = abs(gap1 * gap2 / det);
+        // Shapes flatter than measureSet's own cutoff are lost in rounding, there's nothing to compare.
+        // That cutoff goes by the perimeter, which for a convex shape is under 4 times the widest span.
+        if (!isfinite(expected) || !(expected > 1e-9 * 16 * widest * widest) || !(sine > 1e-6)) return "";
+        if (!metrics.valid) return "measureSet found no shape for a parallelogram";
+        if (abs(metrics.area - expected) > 1e-6 * expected) {
+            ostringstream message;
+            message << setprecision(17) << "measureSet area " << metrics.area << " but the parallelogram's area is " << expected;
+            return message.str();
+        }
+        return "";
+    }
+    return "";
+}
+
+// Runs every check on one case in the current precision mode, returns what failed or "" if all good
+static string checkCaseInMode(const fuzzCase& test) {
+    const vector<int> identity = { 0, 1, 2, 3 };
+
+    // One pass relations against the lines themselves, and the classifier against the original
+    lineRelations relations(test.lines);
+    string failure = checkRelations(test.lines, relations, identity, "lineRelations");
+    if (!failure.empty()) return failure;
+    if (!sameReport(classifyQuadrilateral(relations, identity), referenceClassify(test.lines))) {
+        return "classifyQuadrilateral differs from the original checkQuadrilateral";
+    }
+    failure = checkMetrics(test.lines, lineSet(test.lines));
+    if (!failure.empty()) return failure;
+
+    // An edited lineSet against one built from scratch with the edited lines
+    lineSet set(test.lines);
+    vector<lineType> edited = test.lines;
+    int index = test.editIndex;
+    if (test.editKind == 0) {
+        set.replaceLine(index, test.edit);
+        edited[index] = test.edit;
+    }
+    else if (test.editKind == 1) {
+        set.insertLine(index, test.edit);
+        edited.insert(edited.begin() + index, test.edit);
+        int removed = (index + 2) % static_cast<int>(edited.size());
+        set.removeLine(removed);
+        edited.erase(edited.begin() + removed);
+    }
+    else {
+        set.removeLine(index);
+        edited.erase(edited.begin() + index);
+        set.insertLine(3 - index, test.edit);
+        edited.insert(edited.begin() + (3 - index), test.edit);
+    }
+    failure = checkRelations(edited, set.relations(), set.positions(), "edited lineSet");
+    if (!failure.empty()) return failure;
+    if (!sameReport(set.classification(), referenceClassify(edited))) {
+        return "edited lineSet classification differs from the original checkQuadrilateral";
+    }
+    return "";
+}
+
+// Every check in both modes, and the adaptive quick path against the always exact one
+static string checkCase(const fuzzCase& test) {
+    precisionMode saved = getPrecisionMode();
+    string failure;
+    // Exact mode only needs the pairwise check below, if it matches Adaptive everything after it does too
+    const precisionMode modes[] = { precisionMode::Epsilon, precisionMode::Adaptive };
+    const char* names[] = { "epsilon", "adaptive" };
+    for (int m = 0; m < 2 && failure.empty(); m++) {
+        setPrecisionMode(modes[m]);
+        failure = checkCaseInMode(test);
+        if (!failure.empty()) failure = string(names[m]) + " mode, " + failure;
+    }
+
+    // The quick filter is only allowed to answer when it agrees with the exact arithmetic
+    for (size_t i = 0; i < test.lines.size() && failure.empty(); i++) {
+        for (size_t j = 0; j < test.lines.size() && failure.empty(); j++) {
+            if (i == j) continue;
+            const lineType& l1 = test.lines[i];
+            const lineType& l2 = test.lines[j];
+            setPrecisionMode(precisionMode::Adaptive);
+            bool parallel = l1.isParallel(l2);
+            bool perpendicular = l1.isPerpendicular(l2);
+            Point crossing = l1.findIntersectionPoint(l2);
+            setPrecisionMode(precisionMode::Exact);
+            if (parallel != l1.isParallel(l2) || perpendicular != l1.isPerpendicular(l2) ||
+                !samePoint(crossing, l1.findIntersectionPoint(l2))) {
+                failure = "adaptive quick path disagrees with exact arithmetic for lines " +
+                    to_string(i + 1) + " and " + to_string(j + 1);
+            }
+        }
+    }
+
+    setPrecisionMode(saved);
+    return failure;
+}
+
+// The same metrics from measureSets, which measures in blocks of 64 spread over threads, against
+// measureSet one set at a time. Both should give exactly the same numbers, wherever in a block a set
+// lands and whatever the lane held before. Returns what differed and sets which case, or "" if none.
+static string checkMetricsBatch(const vector<fuzzCase>& batch, size_t& which) {
+    precisionMode saved = getPrecisionMode();
+    string failure;
+    const precisionMode modes[] = { precisionMode::Epsilon, precisionMode::Adaptive };
+    const char* names[] = { "epsilon", "adaptive" };
+    for (int m = 0; m < 2 && failure.empty(); m++) {
+        setPrecisionMode(modes[m]);
+        vector<lineSet> sets;
+        for (const fuzzCase& test : batch) {
+            sets.push_back(lineSet(test.lines));
+        }
+        vector<polygonMetrics> together = measureSets(sets, 4);
+        for (size_t i = 0; i < sets.size() && failure.empty(); i++) {
+            polygonMetrics alone = measureSet(sets[i]);
+            const polygonMetrics& b = together[i];
+            bool same = alone.valid == b.valid && sameNumber(alone.area, b.area) &&
+                sameNumber(alone.perimeter, b.perimeter) && sameNumber(alone.diagonals[0], b.diagonals[0]) &&
+                sameNumber(alone.diagonals[1], b.diagonals[1]) && samePoint(alone.centroid, b.centroid);
+            for (int k = 0; k < 4; k++) {
+                same = same && sameNumber(alone.sides[k], b.sides[k]) && sameNumber(alone.angles[k], b.angles[k]);
+            }
+            if (!same) {
+                failure = string(names[m]) + " mode, measureSets differs from measureSet (set " +
+                    to_string(i + 1) + " of " + to_string(sets.size()) + ")";
+                which = i;
+            }
+        }
+    }
+    setPrecisionMode(saved);
+    return failure;
+}
+
+// Makes up one line, mostly the nasty kinds: vertical, horizontal, copies, scaled copies,
+// parallel and perpendicular partners, nearly parallel, and really huge or tiny coefficients.
+// Never 0x + 0y = c though, that isn't a line and getLineFromUser won't take one either.
+static lineType randomLine(mt19937_64& rng, const vector<lineType>& earlier) {
+    uniform_int_distribution<int> smallInt(-5, 5);
+    uniform_real_distribution<double> anyValue(-100.0, 100.0);
+    uniform_int_distribution<int> kindPick(0, 11);
+    auto nonZero = [&]() { int k = smallInt(rng); return k == 0 ? 1 : k; };
+
+    int kind = kindPick(rng);
+    if (earlier.empty() && kind >= 4 && kind <= 7) kind = 0;   // Those kinds need a line to copy
+    const lineType& base = earlier.empty() ? lineType(1, 1, 0) : earlier[rng() % earlier.size()];
+
+    switch (kind) {
+    case 0: {
+        int a = smallInt(rng);
+        int b = a == 0 ? nonZero() : smallInt(rng);
+        return lineType(a, b, smallInt(rng));
+    }
+    case 1: return lineType(anyValue(rng), anyValue(rng), anyValue(rng));
+    case 2: return lineType(nonZero(), 0, smallInt(rng));                     // Vertical
+    case 3: return lineType(0, nonZero(), smallInt(rng));                     // Horizontal
+    case 4: return base;                                                      // Same line again
+    case 5: {                                                                 // Scaled copy
+        const double scales[] = { 2, -1, 0.5, 3, 0.1, 1e6, -7.25 };
+        double k = scales[rng() % 7];
+        return lineType(base.getA() * k, base.getB() * k, base.getC() * k);
+    }
+    case 6: return lineType(base.getA() * 2, base.getB() * 2, smallInt(rng));  // Parallel, moved over
+    case 7: return lineType(-base.getB(), base.getA(), smallInt(rng));         // Perpendicular
+    case 8: {                                                                 // Huge
+        double k = ldexp(1.0, 400 + static_cast<int>(rng() % 80)) * 1.1;
+        return lineType(smallInt(rng) * k, nonZero() * k, smallInt(rng) * k);
+    }
+    case 9: {                                                                 // Tiny
+        double k = ldexp(1.0, -400 - static_cast<int>(rng() % 80)) * 1.3;
+        return lineType(smallInt(rng) * k, nonZero() * k, smallInt(rng) * k);
+    }
+    case 10: {                                                                // Nearly parallel
+        double nudge = ldexp(1.0, -30 - static_cast<int>(rng() % 30));
+        return lineType(base.getA() * (1 + nudge), base.getB(), base.getC() + 1);
+    }
+    default: {                                                                // Decimals like the data file
+        double a = round(anyValue(rng) * 10) / 10;
+        double b = round(anyValue(rng) * 10) / 10;
+        if (a == 0 && b == 0) b = 1;
+        return lineType(a, b, round(anyValue(rng) * 100) / 100);
+    }
+    }
+}
+
+static fuzzCase randomCase(mt19937_64& rng) {
+    fuzzCase test = { {}, static_cast<int>(rng() % 3), static_cast<int>(rng() % 4), lineType(1, 0, 0) };
+    for (int i = 0; i < 4; i++) {
+        test.lines.push_back(randomLine(rng, test.lines));
+    }
+    test.edit = randomLine(rng, test.lines);
+    return test;
+}
+
+// How many digits it takes to write a number down, fewer digits means a simpler repro
+static int digitsNeeded(double value) {
+    for (int digits = 1; digits < 17; digits++) {
+        ostringstream out;
+        out << setprecision(digits) << value;
+        if (stod(out.str()) == value) return digits;
+    }
+    return 17;
+}
+
+// Shrinks a failing case: keeps swapping coefficients for numbers with fewer digits while it still
+// fails the same way. A smaller case that fails some other way is a different bug, so it isn't kept.
+static fuzzCase shrinkCase(fuzzCase test, const string& failure) {
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (int line = 0; line < 5; line++) {
+            for (int part = 0; part < 3; part++) {
+                lineType& target = (line < 4) ? test.lines[line] : test.edit;
+                double values[3] = { target.getA(), target.getB(), target.getC() };
+                double original = values[part];
+                if (original == 0) continue;
+
+                // Zero first, then small numbers, then the same number with fewer digits
+                vector<double> candidates = { 0, 1, -1, round(original) };
+                for (int digits = 1; digits < 6; digits++) {
+                    ostringstream out;
+                    out << setprecision(digits) << original;
+                    candidates.push_back(stod(out.str()));
+                }
+                for (double candidate : candidates) {
+                    bool simpler = candidate == 0 || digitsNeeded(candidate) < digitsNeeded(original) ||
+                        (digitsNeeded(candidate) == digitsNeeded(original) && abs(candidate) < abs(original));
+                    if (candidate == original || !simpler) continue;
+
+                    values[part] = candidate;
+                    fuzzCase smaller = test;
+                    lineType& changed = (line < 4) ? smaller.lines[line] : smaller.edit;
+                    changed = lineType(values[0], values[1], values[2]);
+                    if (values[0] == 0 && values[1] == 0) {   // Not a line any more
+                        values[part] = original;
+                        continue;
+                    }
+                    if (checkCase(smaller) == failure) {
+                        test = smaller;
+                        progress = true;
+                        break;
+                    }
+                    values[part] = original;
+                }
+            }
+        }
+    }
+    return test;
+}
+
+// Prints a case so it can be pasted into a lines file, with just enough digits to get the same numbers back
+static void printCase(const fuzzCase& test) {
+    auto write = [](const lineType& line) {
+        cout << setprecision(digitsNeeded(line.getA())) << line.getA() << " "
+            << setprecision(digitsNeeded(line.getB())) << line.getB() << " "
+            << setprecision(digitsNeeded(line.getC())) << line.getC();
+    };
+    for (const lineType& line : test.lines) {
+        cout << "  ";
+        write(line);
+        cout << endl;
+    }
+    const char* edits[] = { "replace", "insert", "remove+insert" };
+    cout << "  edit: " << edits[test.editKind] << " at line " << (test.editIndex + 1) << " with ";
+    write(test.edit);
+    cout << endl << setprecision(6);
+}
+
+// Checks lots of random cases and shrinks the first few failures down to small repros
+int runFuzzHarness(unsigned long long cases, unsigned long long seed) {
+    const int MAX_REPORTED = 5;
+    mt19937_64 rng(seed);
+    int failures = 0;
+    unsigned long long n = 0;
+    auto start = chrono::steady_clock::now();
+
+    // measureSets only starts another thread for every 1024 sets, so the batch needs more than
+    // 4 * 1024 to use all 4. The extra 37 leave the last block part full.
+    const size_t METRICS_BATCH = 4 * 1024 + 37;
+    vector<fuzzCase> batch;
+    unsigned long long batchStart = 0;
+
+    for (; n < cases && failures < MAX_REPORTED; n++) {
+        fuzzCase test = randomCase(rng);
+        if (batch.empty()) batchStart = n;
+        batch.push_back(test);
+
+        // A whole batch (or what's left at the end) goes through the batched metrics in one go
+        if (batch.size() == METRICS_BATCH || n + 1 == cases) {
+            size_t which = 0;
+            string batchFailure = checkMetricsBatch(batch, which);
+            if (!batchFailure.empty()) {
+                failures++;
+                cout << "Case " << (batchStart + which) << " failed: " << batchFailure << endl;
+                printCase(batch[which]);
+            }
+            batch.clear();
+        }
+
+        string failure = checkCase(test);
+        if (failure.empty()) continue;
+
+        failures++;
+        fuzzCase small = shrinkCase(test, failure);
+        cout << "Case " << n << " failed: " << failure << endl;
+        printCase(test);
+        cout << "Shrunk to: " << checkCase(small) << endl;
+        printCase(small);
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Fuzzed " << n << " cases (seed " << seed << ") in " << fixed << setprecision(2)
+        << seconds << "s, " << failures << " failure" << (failures == 1 ? "" : "s") << endl;
+    return failures;
+}
@@ -6,12 +6,146 @@
 #include <iomanip>        // For making our output look neat
 #include <cstdlib>        // For system stuff like clearing the screen
 #include <sstream>        // For working with strings as streams
+#include <cctype>         // For isdigit and isspace
 #include <string>         // For text manipulation
+#include <atomic>         // For counters that are safe to bump from anywhere
+#include <cfloat>         // For DBL_EPSILON
 
 using namespace std;      // So we don't have to write std:: all the time
 // If two numbers are super close (within 0.000000001), we'll treat them as equal, helps avoid floating point comparison headaches
 const double EPSILON = 1e-9;
 
+// Adaptive mode calls two lines parallel (or perpendicular) when the angle test is off by less than
+// about 6e-14 of the line sizes, that's a power of two so multiplying by it is exact
+const double ADAPTIVE_TOLERANCE = 1.0 / 17592186044416.0;   // 2^-44
+
+// Which way the tests go, and how often the adaptive ones needed the slow path
+static atomic<precisionMode> currentMode(precisionMode::Epsilon);
+static atomic<unsigned long long> fastPathCount(0);
+static atomic<unsigned long long> exactPathCount(0);
+
+void setPrecisionMode(precisionMode mode) { currentMode = mode; }
+precisionMode getPrecisionMode() { return currentMode; }
+
+predicateCounters getPredicateCounters() {
+    predicateCounters counters;
+    counters.fastPath = fastPathCount.load(memory_order_relaxed);
+    counters.exactPath = exactPathCount.load(memory_order_relaxed);
+    return counters;
+}
+
+// Says how the adaptive tests went, nothing in Epsilon mode since it doesn't count
+void printPredicateCounters(ostream& out) {
+    if (currentMode != precisionMode::Epsilon) {
+        predicateCounters counters = getPredicateCounters();
+        out << "Adaptive tests: " << counters.fastPath << " quick, "
+            << counters.exactPath << " needed exact arithmetic" << endl;
+    }
+}
+
+// Every way out of the menus ends here, so the adaptive counts get printed whichever exit was picked
+void exitProgram() {
+    printPredicateCounters(cout);
+    exit(0);
+}
+
+// Scales a line by a power of two so its biggest of a, b is between 1 and 2. Powers of two don't
+// change any digits, so this is exact, and huge or tiny coefficients can't overflow anymore.
+static void normalizeLine(double& a, double& b, double& c) {
+    double biggest = max(abs(a), abs(b));
+    if (biggest == 0 || isinf(biggest) || isnan(biggest)) return;
+    int exponent = ilogb(biggest);
+    a = ldexp(a, -exponent);
+    b = ldexp(b, -exponent);
+    c = ldexp(c, -exponent);
+}
+
+// Adds two doubles exactly, sum + error is the true answer
+static void twoSum(double a, double b, double& sum, double& error) {
+    sum = a + b;
+    double bigPart = sum - a;
+    error = (a - (sum - bigPart)) + (b - bigPart);
+}
+
+// Exact sign of a sum of doubles. Every term is added into a list of non-overlapping parts
+// with no rounding at all (Shewchuk's grow-expansion), and the biggest part has the sign of the total.
+static int exactSign(const double* terms, int count) {
+    double parts[32];
+    int size = 0;
+    for (int k = 0; k < count; k++) {
+        double q = terms[k];
+        int kept = 0;
+        for (int i = 0; i < size; i++) {
+            double sum, error;
+            twoSum(q, parts[i], sum, error);
+            q = sum;
+            if (error != 0) parts[kept++] = error;
+        }
+        if (q != 0) parts[kept++] = q;
+        size = kept;
+    }
+    if (size == 0) return 0;
+    return parts[size - 1] > 0 ? 1 : -1;
+}
+
+// Decides if x1*y2 + sign*x2*y1 counts as zero next to the line sizes. With sign = -1 that's the
+// cross product (parallel test), with sign = +1 it's the dot product (perpendicular test).
+// The quick answer is trusted unless it's within rounding distance of the cutoff, then we redo it exactly.
+// In Exact mode the quick check is skipped, so every answer comes from the exact arithmetic.
+static bool adaptiveNearZero(double x1, double y1, double x2, double y2, double sign) {
+    if (currentMode != precisionMode::Exact) {
+        double size1 = abs(x1) + abs(y1);
+        double size2 = abs(x2) + abs(y2);
+        double value = x1 * y2 + sign * (x2 * y1);
+        double limit = ADAPTIVE_TOLERANCE * size1 * size2;
+
+        // value is off by at most about 3 rounding units of size1 * size2, limit by even less
+        double slack = 4 * DBL_EPSILON * size1 * size2;
+        double gap = limit - abs(value);
+        if (abs(gap) > slack) {
+            fastPathCount.fetch_add(1, memory_order_relaxed);
+            return gap > 0;
+        }
+    }
+    exactPathCount.fetch_add(1, memory_order_relaxed);
+
+    // Exact products: p + e is exactly the product, fma gives us the rounding error e
+    double p1 = x1 * y2, e1 = fma(x1, y2, -p1);
+    double p2 = sign * (x2 * y1), e2 = fma(sign * x2, y1, -p2);
+    double valueTerms[4] = { p1, e1, p2, e2 };
+    int valueSign = exactSign(valueTerms, 4);
+
+    // Exact sizes: s + t is exactly |x| + |y|
+    double s1, t1, s2, t2;
+    twoSum(abs(x1), abs(y1), s1, t1);
+    twoSum(abs(x2), abs(y2), s2, t2);
+
+    // limit - |value|, all of it exact
+    double terms[12];
+    int count = 0;
+    const double left[2] = { s1, t1 };
+    const double right[2] = { s2, t2 };
+    for (double l : left) {
+        for (double r : right) {
+            double product = l * r;
+            terms[count++] = ADAPTIVE_TOLERANCE * product;
+            terms[count++] = ADAPTIVE_TOLERANCE * fma(l, r, -product);
+        }
+    }
+    for (double v : valueTerms) {
+        terms[count++] = -valueSign * v;
+    }
+    return exactSign(terms, count) >= 0;
+}
+
+// Works out a*b - c*d with fma so the answer is good to the last digit or so (Kahan's trick)
+static double differenceOfProducts(double a, double b, double c, double d) {
+    double cd = c * d;
+    double error = fma(-c, d, cd);
+    double difference = fma(a, b, -cd);
+    return difference + error;
+}
+
 // Constructor implementation,setting up a line with its a, b, c values, in ax + by = c 
 lineType::lineType(double a, double b, double c) : a(a), b(b), c(c) {}
 
@@ -31,6 +165,12 @@ double lineType::getSlope() const {
 
 // Checks if two lines are parallel, either they're both vertical or have the same slope
 bool lineType::isParallel(const lineType& other) const {
+    if (currentMode != precisionMode::Epsilon) {
+        double a1 = a, b1 = b, c1 = c, a2 = other.a, b2 = other.b, c2 = other.c;
+        normalizeLine(a1, b1, c1);
+        normalizeLine(a2, b2, c2);
+        return adaptiveNearZero(a1, b1, a2, b2, -1);    // a1*b2 - a2*b1 is about zero
+    }
     if (abs(b) < EPSILON && abs(other.b) < EPSILON) {
         return true;
     }
@@ -39,6 +179,12 @@ bool lineType::isParallel(const lineType& other) const {
 
 // Checks if lines are perpendicular
 bool lineType::isPerpendicular(const lineType& other) const {
+    if (currentMode != precisionMode::Epsilon) {
+        double a1 = a, b1 = b, c1 = c, a2 = other.a, b2 = other.b, c2 = other.c;
+        normalizeLine(a1, b1, c1);
+        normalizeLine(a2, b2, c2);
+        return adaptiveNearZero(a1, b1, b2, a2, 1);     // a1*a2 + b1*b2 is about zero
+    }
     const double slope1 = getSlope();
     const double slope2 = other.getSlope();
 
@@ -51,6 +197,21 @@ bool lineType::isPerpendicular(const lineType& other) const {
 
 // Finds where two lines cross
 Point lineType::findIntersectionPoint(const lineType& other) const {
+    if (currentMode != precisionMode::Epsilon) {
+        // Always work from the same line first, so A crossing B gives exactly the same digits as B crossing A
+        const lineType& first = (a < other.a || (a == other.a && (b < other.b || (b == other.b && c < other.c)))) ? *this : other;
+        const lineType& second = (&first == this) ? other : *this;
+        double a1 = first.a, b1 = first.b, c1 = first.c, a2 = second.a, b2 = second.b, c2 = second.c;
+        normalizeLine(a1, b1, c1);
+        normalizeLine(a2, b2, c2);
+        if (adaptiveNearZero(a1, b1, a2, b2, -1)) {
+            return Point(numeric_limits<double>::infinity(),
+                numeric_limits<double>::infinity());
+        }
+        double det = differenceOfProducts(a1, b2, a2, b1);
+        return Point(differenceOfProducts(b1, c2, b2, c1) / det,
+            differenceOfProducts(a2, c1, a1, c2) / det);
+    }
     double det = a * other.b - other.a * b;
     if (abs(det) < EPSILON) {
         return Point(numeric_limits<double>::infinity(),
@@ -64,7 +225,305 @@ Point lineType::findIntersectionPoint(const lineType& other) const {
 
 // Calculate distance between two points
 double calculateDistance(const Point& p1, const Point& p2) {
-    return sqrt(pow(p2.x - p1.x, 2) + pow(p2.y - p1.y, 2));
+    double dx = p2.x - p1.x;
+    double dy = p2.y - p1.y;
+    return sqrt(dx * dx + dy * dy);
+}
+
+// lineRelations implementation, one pass over every pair of lines fills in all three answers
+lineRelations::lineRelations(const vector<lineType>& lines) {
+    int n = static_cast<int>(min(lines.size(), static_cast<size_t>(MAX_LINES)));
+    parallelMask.assign(n, 0);
+    perpendicularMask.assign(n, 0);
+    crossings.assign(n, vector<Point>(n));
+
+    for (int i = 0; i < n; i++) {
+        for (int j = i + 1; j < n; j++) {
+            if (lines[i].isParallel(lines[j])) {
+                parallelMask[i] |= 1ULL << j;
+                parallelMask[j] |= 1ULL << i;
+            }
+            if (lines[i].isPerpendicular(lines[j])) {
+                perpendicularMask[i] |= 1ULL << j;
+                perpendicularMask[j] |= 1ULL << i;
+            }
+            // The crossing point is the same whichever line we start from
+            Point p = lines[i].findIntersectionPoint(lines[j]);
+            crossings[i][j] = p;
+            crossings[j][i] = p;
+        }
+    }
+}
+
+int lineRelations::size() const { return static_cast<int>(parallelMask.size()); }
+
+bool lineRelations::isParallel(int i, int j) const {
+    return (parallelMask[i] >> j) & 1ULL;
+}
+
+bool lineRelations::isPerpendicular(int i, int j) const {
+    return (perpendicularMask[i] >> j) & 1ULL;
+}
+
+Point lineRelations::intersection(int i, int j) const {
+    return crossings[i][j];
+}
+
+// Makes room for the new last line and works out its pairs
+void lineRelations::appendLine(const vector<lineType>& lines) {
+    parallelMask.push_back(0);
+    perpendicularMask.push_back(0);
+    for (vector<Point>& row : crossings) {
+        row.push_back(Point());
+    }
+    crossings.push_back(vector<Point>(parallelMask.size()));
+    updateLine(size() - 1, lines);
+}
+
+// Works out every pair that has this line in it, that's one pass over the other lines
+void lineRelations::updateLine(int index, const vector<lineType>& lines) {
+    unsigned long long bit = 1ULL << index;
+    parallelMask[index] = 0;
+    perpendicularMask[index] = 0;
+
+    for (int other = 0; other < size(); other++) {
+        if (other == index) continue;
+        unsigned long long otherBit = 1ULL << other;
+
+        parallelMask[other] &= ~bit;
+        perpendicularMask[other] &= ~bit;
+        if (lines[index].isParallel(lines[other])) {
+            parallelMask[index] |= otherBit;
+            parallelMask[other] |= bit;
+        }
+        if (lines[index].isPerpendicular(lines[other])) {
+            perpendicularMask[index] |= otherBit;
+            perpendicularMask[other] |= bit;
+        }
+
+        Point p = lines[index].findIntersectionPoint(lines[other]);
+        crossings[index][other] = p;
+        crossings[other][index] = p;
+    }
+}
+
+// Forgets a line, the last line's answers move into its place so everything stays packed
+void lineRelations::removeLine(int index) {
+    int last = size() - 1;
+    unsigned long long holeBit = 1ULL << index;
+    unsigned long long lastBit = 1ULL << last;
+
+    if (index != last) {
+        parallelMask[index] = parallelMask[last];
+        perpendicularMask[index] = perpendicularMask[last];
+        crossings[index] = crossings[last];
+        for (int s = 0; s < last; s++) {
+            // Bit "last" moves to bit "index" in every row
+            parallelMask[s] = (parallelMask[s] & ~holeBit) | ((parallelMask[s] & lastBit) ? holeBit : 0);
+            perpendicularMask[s] = (perpendicularMask[s] & ~holeBit) | ((perpendicularMask[s] & lastBit) ? holeBit : 0);
+            crossings[s][index] = crossings[s][last];
+        }
+    }
+
+    parallelMask.pop_back();
+    perpendicularMask.pop_back();
+    crossings.pop_back();
+    for (int s = 0; s < last; s++) {
+        parallelMask[s] &= ~lastBit;
+        perpendicularMask[s] &= ~lastBit;
+        crossings[s].pop_back();
+    }
+}
+
+// lineSet implementation, a set of lines that keeps the answers for every pair around
+lineSet::lineSet() {}
+
+lineSet::lineSet(const vector<lineType>& lines) {
+    for (size_t i = 0; i < lines.size() && i < static_cast<size_t>(MAX_LINES); i++) {
+        slots.push_back(lines[i]);
+        order.push_back(static_cast<int>(i));
+    }
+    pairs = lineRelations(slots);
+    report = classifyQuadrilateral(pairs, order);
+}
+
+int lineSet::size() const { return static_cast<int>(order.size()); }
+const lineType& lineSet::line(int index) const { return slots[order[index]]; }
+const lineRelations& lineSet::relations() const { return pairs; }
+const vector<int>& lineSet::positions() const { return order; }
+const shapeReport& lineSet::classification() const { return report; }
+
+// Copies the lines out in position order
+vector<lineType> lineSet::lines() const {
+    vector<lineType> result;
+    for (int slot : order) {
+        result.push_back(slots[slot]);
+    }
+    return result;
+}
+
+bool lineSet::isParallel(int i, int j) const {
+    return pairs.isParallel(order[i], order[j]);
+}
+
+bool lineSet::isPerpendicular(int i, int j) const {
+    return pairs.isPerpendicular(order[i], order[j]);
+}
+
+Point lineSet::intersection(int i, int j) const {
+    return pairs.intersection(order[i], order[j]);
+}
+
+// Swaps one line for another, only the pairs with that line get recomputed
+bool lineSet::replaceLine(int index, const lineType& line) {
+    if (index < 0 || index >= size()) return false;
+    slots[order[index]] = line;
+    pairs.updateLine(order[index], slots);
+    report = classifyQuadrilateral(pairs, order);
+    return true;
+}
+
+// Puts a new line in front of the one at index (index == size() adds it at the end)
+bool lineSet::insertLine(int index, const lineType& line) {
+    if (index < 0 || index > size() || size() >= MAX_LINES) return false;
+
+    // New lines always go in a fresh slot at the end, so nothing else has to move
+    slots.push_back(line);
+    order.insert(order.begin() + index, static_cast<int>(slots.size()) - 1);
+    pairs.appendLine(slots);
+    report = classifyQuadrilateral(pairs, order);
+    return true;
+}
+
+// Takes a line out of the set, the last slot moves into the hole so slots stay packed
+bool lineSet::removeLine(int index) {
+    if (index < 0 || index >= size()) return false;
+
+    int hole = order[index];
+    int last = static_cast<int>(slots.size()) - 1;
+    order.erase(order.begin() + index);
+
+    slots[hole] = slots[last];
+    slots.pop_back();
+    for (int& slot : order) {
+        if (slot == last) slot = hole;
+    }
+    pairs.removeLine(hole);
+
+    report = classifyQuadrilateral(pairs, order);
+    return true;
+}
+
+// Picks 4 corners for the classifier, starting at the top and walking to the nearest corner we
+// haven't used yet. Returns fewer than 4 points if the lines don't close up. This is only a guess at
+// the real corners: the nearest crossing isn't always the next corner (lineData.txt set 2 comes out
+// with its diagonals as 2 of the sides), so the metrics find their corners from the sides instead.
+static vector<Point> quadrilateralVertices(const lineRelations& relations, const vector<int>& order) {
+    if (order.size() != 4) return {};
+
+    // Get all the intersections that actually exist
+    vector<Point> allIntersections;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = i + 1; j < 4; ++j) {
+            Point p = relations.intersection(order[i], order[j]);
+            if (!isinf(p.x) && !isinf(p.y)) {
+                allIntersections.push_back(p);
+            }
+        }
+    }
+
+    // Reorder points to form the quadrilateral
+    vector<Point> orderedPoints;
+    if (allIntersections.size() >= 4) {
+        // Find the topmost point to start
+        int topmost = 0;
+        for (size_t i = 1; i < allIntersections.size(); i++) {
+            if (allIntersections[i].y > allIntersections[topmost].y) {
+                topmost = i;
+            }
+        }
+        orderedPoints.push_back(allIntersections[topmost]);
+
+        // Find remaining points based on proximity
+        vector<bool> used(allIntersections.size(), false);
+        used[topmost] = true;
+
+        for (int i = 0; i < 3; i++) {
+            double minDist = numeric_limits<double>::max();
+            int nextPoint = -1;
+
+            for (size_t j = 0; j < allIntersections.size(); j++) {
+                if (!used[j]) {
+                    double dist = calculateDistance(orderedPoints.back(), allIntersections[j]);
+                    if (dist < minDist) {
+                        minDist = dist;
+                        nextPoint = j;
+                    }
+                }
+            }
+
+            if (nextPoint != -1) {
+                orderedPoints.push_back(allIntersections[nextPoint]);
+                used[nextPoint] = true;
+            }
+        }
+    }
+
+    return orderedPoints;
+}
+
+// Figures out what shape 4 lines make, using only the answers in the relations.
+// order[k] is the relation index of the k-th line of the shape.
+shapeReport classifyQuadrilateral(const lineRelations& relations, const vector<int>& order) {
+    shapeReport report;
+    if (order.size() != 4) return report;
+
+    auto isParallel = [&](int i, int j) { return relations.isParallel(order[i], order[j]); };
+    auto isPerpendicular = [&](int i, int j) { return relations.isPerpendicular(order[i], order[j]); };
+
+    vector<Point> orderedPoints = quadrilateralVertices(relations, order);
+
+    // Calculate side lengths using ordered points
+    if (orderedPoints.size() == 4) {
+        report.sideLengths.push_back(calculateDistance(orderedPoints[0], orderedPoints[1]));
+        report.sideLengths.push_back(calculateDistance(orderedPoints[1], orderedPoints[2]));
+        report.sideLengths.push_back(calculateDistance(orderedPoints[2], orderedPoints[3]));
+        report.sideLengths.push_back(calculateDistance(orderedPoints[3], orderedPoints[0]));
+    }
+    vector<double> sideLengths = report.sideLengths;
+    sort(sideLengths.begin(), sideLengths.end());
+
+    // Reorganize lines so parallel pairs are grouped correctly
+    int r[4] = { 0, 1, 2, 3 };
+    if (!isParallel(0, 2)) {
+        swap(r[1], r[2]);
+    }
+
+    bool equalSides = (sideLengths.size() == 4) &&
+        (abs(sideLengths[0] - sideLengths[3]) < EPSILON);
+
+    bool equalOpposites = (sideLengths.size() == 4) &&
+        (abs(sideLengths[0] - sideLengths[1]) < EPSILON) &&
+        (abs(sideLengths[2] - sideLengths[3]) < EPSILON);
+
+    bool isParallelogram = isParallel(r[0], r[2]) && isParallel(r[1], r[3]);
+
+    bool allRightAngles = isPerpendicular(r[0], r[1]) &&
+        isPerpendicular(r[1], r[2]) &&
+        isPerpendicular(r[2], r[3]) &&
+        isPerpendicular(r[3], r[0]);
+
+    bool isTrapezoid = (isParallel(r[0], r[2]) && !isParallel(r[1], r[3])) ||
+        (isParallel(r[1], r[3]) && !isParallel(r[0], r[2]));
+
+    if (allRightAngles && isParallelogram && equalSides) report.type = shapeType::Square;
+    else if (allRightAngles && isParallelogram && equalOpposites) report.type = shapeType::Rectangle;
+    else if (isParallelogram && equalSides) report.type = shapeType::Rhombus;
+    else if (isParallelogram) report.type = shapeType::Parallelogram;
+    else if (isTrapezoid) report.type = shapeType::Trapezoid;
+    else report.type = shapeType::Irregular;
+
+    return report;
 }
 
 // Canvas ipmlementation, this is for drawing our shapes and lines.
@@ -137,24 +596,25 @@ void Canvas::plotSegment(const Point& start, const Point& end, char symbol) {
     }
 }
 // Shows our ASCII display
-void Canvas::display() const {
-    cout << string(WIDTH + 2, '-') << endl;
+void Canvas::display(ostream& out) const {
+    out << string(WIDTH + 2, '-') << endl;
     for (int y = 0; y < HEIGHT; y++) {
-        cout << '|';
+        out << '|';
         for (int x = 0; x < WIDTH; x++) {
-            cout << grid[y][x];
+            out << grid[y][x];
         }
-        cout << '|' << endl;
+        out << '|' << endl;
     }
-    cout << string(WIDTH + 2, '-') << endl;
+    out << string(WIDTH + 2, '-') << endl;
 }
 
 // Helper function to clear the screen
+// (on Linux/Mac this is just the terminal's own clear code, no need to start a whole shell for it)
 void clearScreen() {
 #ifdef _WIN32
     system("cls");
 #else
-    system("clear");
+    cout << "\033[2J\033[H" << flush;
 #endif
 }
 // Makes the program wait until user hits Enter
@@ -181,6 +641,72 @@ void Display(const std::vector<std::vector<lineType>>& allLines) {
         cout << endl;
     }
 }
+// Reads one number at text[pos] the same way >> reads a double: an optional sign, digits with an
+// optional decimal point, and an optional exponent. inf, nan and hex aren't numbers here, and neither
+// is anything too big for a double. Moves pos past the number, or returns false and leaves pos alone.
+static bool readNumberAt(const string& text, size_t& pos, double& value) {
+    auto isDigit = [&](size_t at) { return at < text.size() && isdigit(static_cast<unsigned char>(text[at])); };
+    size_t at = pos;
+    if (at < text.size() && (text[at] == '+' || text[at] == '-')) at++;
+    size_t digits = 0;
+    while (isDigit(at)) { at++; digits++; }
+    if (at < text.size() && text[at] == '.') {
+        at++;
+        while (isDigit(at)) { at++; digits++; }
+    }
+    if (digits == 0) return false;
+    if (at < text.size() && (text[at] == 'e' || text[at] == 'E')) {
+        at++;
+        if (at < text.size() && (text[at] == '+' || text[at] == '-')) at++;
+        if (!isDigit(at)) return false;    // >> gives up on "1e" as well
+        while (isDigit(at)) at++;
+    }
+
+    // Only convert the part we checked, strtod on its own would also take things like 0x1p3
+    string number = text.substr(pos, at - pos);
+    value = strtod(number.c_str(), nullptr);
+    if (isinf(value)) return false;
+    pos = at;
+    return true;
+}
+
+// Reads the set of 4 lines (12 numbers) starting at pos. Every loader goes through here, so a file
+// means the same thing however it's read. NoMore means there's no set at pos (the text ended, or
+// there's something that isn't a number where a set would start); Unfinished means the text ran out
+// or stopped being numbers partway through a set.
+setReadResult readLineSet(const string& text, size_t& pos, vector<lineType>& lines) {
+    double values[12];
+    size_t at = pos;
+    for (int k = 0; k < 12; k++) {
+        while (at < text.size() && isspace(static_cast<unsigned char>(text[at]))) at++;
+        if (!readNumberAt(text, at, values[k])) {
+            return k == 0 ? setReadResult::NoMore : setReadResult::Unfinished;
+        }
+    }
+
+    lines.clear();
+    for (int k = 0; k < 12; k += 3) {
+        lines.push_back(lineType(values[k], values[k + 1], values[k + 2]));
+    }
+    pos = at;
+    return setReadResult::Found;
+}
+
+// Reads sets of lines, 3 numbers per line and 4 lines per set, blank lines don't matter
+bool loadLineSets(istream& in, vector<vector<lineType>>& allLines) {
+    ostringstream contents;
+    contents << in.rdbuf();
+    string text = contents.str();
+
+    size_t pos = 0;
+    vector<lineType> lines;
+    while (true) {
+        setReadResult result = readLineSet(text, pos, lines);
+        if (result == setReadResult::NoMore) return true;
+        if (result == setReadResult::Unfinished) return false;
+        allLines.push_back(lines);
+    }
+}
 // Makes sure users type actual numbers and not random stuff
 int getValidIntegerInput() {
     int input;
@@ -201,15 +727,22 @@ int getValidIntegerInput() {
 void displayVisualization(const vector<lineType>& lines) {
     if (lines.size() != 4) return;
 
+    displayVisualization(lineRelations(lines), { 0, 1, 2, 3 });
+}
+// Draws the shape from relations we already worked out, order[k] is the relation index of line k.
+// Everything goes to out, so the command mode can grab the drawing instead of printing it.
+void displayVisualization(const lineRelations& relations, const vector<int>& order, ostream& out) {
+    if (order.size() != 4) return;
+
     Canvas canvas; // Create our drawing canvas
     vector<Point> allIntersections; // Will store all points where lines cross
     vector<vector<Point>> lineIntersections(4); // Keeps track of which intersections belong to which line
 
-    // First find all the places where any two lines cross
-    for (size_t i = 0; i < lines.size(); i++) {
-        for (size_t j = 0; j < lines.size(); j++) {
-            if (i != j && !lines[i].isParallel(lines[j])) {
-                Point p = lines[i].findIntersectionPoint(lines[j]);
+    // First collect all the places where any two lines cross
+    for (size_t i = 0; i < order.size(); i++) {
+        for (size_t j = 0; j < order.size(); j++) {
+            if (i != j && !relations.isParallel(order[i], order[j])) {
+                Point p = relations.intersection(order[i], order[j]);
                 if (!isinf(p.x) && !isinf(p.y)) {
                     allIntersections.push_back(p);
                     lineIntersections[i].push_back(p);
@@ -221,9 +754,9 @@ void displayVisualization(const vector<lineType>& lines) {
 
     // Find parallel lines
     int line1 = -1, line2 = -1;
-    for (size_t i = 0; i < lines.size(); i++) {
-        for (size_t j = i + 1; j < lines.size(); j++) {
-            if (lines[i].isParallel(lines[j])) {
+    for (size_t i = 0; i < order.size(); i++) {
+        for (size_t j = i + 1; j < order.size(); j++) {
+            if (relations.isParallel(order[i], order[j])) {
                 line1 = i;
                 line2 = j;
                 break;
@@ -285,7 +818,7 @@ void displayVisualization(const vector<lineType>& lines) {
     // This is if something went wrong finding the points
 
     if (orderedPoints.empty()) {
-        cout << "Could not determine shape vertices." << endl;
+        out << "Could not determine shape vertices." << endl;
         return;
     }
 
@@ -318,13 +851,13 @@ void displayVisualization(const vector<lineType>& lines) {
         canvas.plotSegment(orderedPoints[i], orderedPoints[i + 1], symbols[i % 4]);
     }
     // Show which symbol means which side
-    cout << "Shape Visualization:\n" << endl;
+    out << "Shape Visualization:\n" << endl;
     for (size_t i = 0; i < 4; i++) {
-        cout << "Segment " << (i + 1) << ": " << symbols[i] << endl;
+        out << "Segment " << (i + 1) << ": " << symbols[i] << endl;
     }
-    cout << endl;
+    out << endl;
 
-    canvas.display(); // Displays the drawing
+    canvas.display(out); // Displays the drawing
 }
 
 // Figures out where two lines cross and tells us about it
@@ -340,9 +873,14 @@ void findIntersection(const lineType& line1, const lineType& line2) {
 }
 // Tells us everything we want to know about how two lines relate to each other
 void checkLines(const lineType& line1, const lineType& line2) {
-    bool isParallel = line1.isParallel(line2);
-    bool isPerpendicular = line1.isPerpendicular(line2);
-    Point intersection = line1.findIntersectionPoint(line2);
+    checkLines(line1, line2, lineRelations({ line1, line2 }), 0, 1);
+}
+// Same as above, but reads the answers from relations where index1 and index2 are the two lines
+void checkLines(const lineType& line1, const lineType& line2,
+    const lineRelations& relations, int index1, int index2) {
+    bool isParallel = relations.isParallel(index1, index2);
+    bool isPerpendicular = relations.isPerpendicular(index1, index2);
+    Point intersection = relations.intersection(index1, index2);
 
     if (isParallel) {
         cout << "The lines are parallel." << endl;
@@ -427,27 +965,42 @@ void showShape(const vector<lineType>& lines) {
         return;
     }
 
+    showShape(lineSet(lines));
+}
+// Same as above, but the set already knows how its lines relate so nothing gets recomputed
+void showShape(const lineSet& set) {
+    if (set.size() != 4) {
+        cout << "Error: Need exactly 4 lines to analyze a shape!" << endl;
+        return;
+    }
+
     cout << "\nInformation about the lines:" << endl;
     cout << "----------------" << endl;
-    for (size_t i = 0; i < lines.size(); i++) {
+    for (int i = 0; i < set.size(); i++) {
         cout << "Line " << (i + 1) << ": ";
-        if (abs(lines[i].getB()) < EPSILON) {
+        if (abs(set.line(i).getB()) < EPSILON) {
             cout << "Vertical line";
         }
         else {
-            cout << "Slope = " << fixed << setprecision(3) << lines[i].getSlope();
+            cout << "Slope = " << fixed << setprecision(3) << set.line(i).getSlope();
         }
         cout << endl;
     }
 
-    checkQuadrilateral(lines);
+    printShapeReport(set.classification());
     //Shows the drawing of the shape
     cout << "\nVisualization:" << endl;
-    displayVisualization(lines);
+    displayVisualization(set.relations(), set.positions());
 }
 
 // Menu for comparing different lines
 void compareLinesMenu(const vector<vector<lineType>>& allLines) {
+    // Work out how the lines in each set relate once, then every comparison just looks it up
+    vector<lineRelations> allRelations;
+    for (const vector<lineType>& lines : allLines) {
+        allRelations.push_back(lineRelations(lines));
+    }
+
     while (true) {
         displayHeader("Compare Lines");
         Display(allLines); 
@@ -478,7 +1031,8 @@ void compareLinesMenu(const vector<vector<lineType>>& allLines) {
         } while (line2 < 1 || line2 > 4 || line2 == line1);
 
         displayHeader("Line Comparison Results");
-        checkLines(allLines[setChoice - 1][line1 - 1], allLines[setChoice - 1][line2 - 1]);
+        checkLines(allLines[setChoice - 1][line1 - 1], allLines[setChoice - 1][line2 - 1],
+            allRelations[setChoice - 1], line1 - 1, line2 - 1);
 
         int option;
         do {
@@ -495,11 +1049,17 @@ void compareLinesMenu(const vector<vector<lineType>>& allLines) {
         } while (option < 1 || option > 3);
 
         if (option == 2) break;
-        if (option == 3) exit(0);
+        if (option == 3) exitProgram();
     }
 }
 // Menu for analyzing shapes
 void showShapesMenu(const vector<vector<lineType>>& allLines) {
+    // Each set is analyzed once up front, showing a shape again just reads the cached answers
+    vector<lineSet> allSets;
+    for (const vector<lineType>& lines : allLines) {
+        allSets.push_back(lineSet(lines));
+    }
+
     while (true) {
         displayHeader("Shape Analysis");
         Display(allLines); 
@@ -513,7 +1073,7 @@ void showShapesMenu(const vector<vector<lineType>>& allLines) {
         } while (setNumber < 1 || setNumber > static_cast<int>(allLines.size()));
 
         displayHeader("Shape Analysis Results");
-        showShape(allLines[setNumber - 1]);
+        showShape(allSets[setNumber - 1]);
 
         int option;
         do {
@@ -530,7 +1090,7 @@ void showShapesMenu(const vector<vector<lineType>>& allLines) {
         } while (option < 1 || option > 3);
 
         if (option == 2) break;
-        if (option == 3) exit(0);
+        if (option == 3) exitProgram();
     }
 }
 // Gets a line equation from the user, ax + by = c
@@ -558,30 +1118,51 @@ lineType getLineFromUser(const string& lineNumber) {
 
     return lineType(a, b, c);
 }
+// Asks which line to change and swaps in a new one, the set only redoes that line's pairs
+void editLineInSet(lineSet& set) {
+    int index;
+    do {
+        cout << "Which line do you want to change (1-" << set.size() << "): ";
+        index = getValidIntegerInput();
+        if (index < 1 || index > set.size()) {
+            cout << "Invalid line number! Please choose between 1 and " << set.size() << endl;
+        }
+    } while (index < 1 || index > set.size());
+
+    set.replaceLine(index - 1, getLineFromUser("line " + to_string(index)));
+}
 // Menu for comparing lines that the user types in
 void compareCustomLinesMenu() {
     while (true) {
         displayHeader("Compare Custom Lines");
 
-        lineType line1 = getLineFromUser("first line");
-        lineType line2 = getLineFromUser("second line");
-
-        displayHeader("Line Comparison Results");
-        checkLines(line1, line2);
+        lineSet set;
+        set.insertLine(0, getLineFromUser("first line"));
+        set.insertLine(1, getLineFromUser("second line"));
 
         int option;
         do {
-            cout << "\nWhat would you like to do?" << endl;
-            cout << "1. Compare more lines" << endl;
-            cout << "2. Return to main menu" << endl;
-            cout << "3. Exit program" << endl;
-            cout << "\nChoice: ";
+            displayHeader("Line Comparison Results");
+            checkLines(set.line(0), set.line(1), set.relations(), set.positions()[0], set.positions()[1]);
+
+            do {
+                cout << "\nWhat would you like to do?" << endl;
+                cout << "1. Compare more lines" << endl;
+                cout << "2. Return to main menu" << endl;
+                cout << "3. Exit program" << endl;
+                cout << "4. Change one of the lines" << endl;
+                cout << "\nChoice: ";
+
+                option = getValidIntegerInput();
+                if (option < 1 || option > 4) {
+                    cout << "Invalid choice! Please enter 1 to compare more lines, 2 to return to main menu, 3 to exit, or 4 to change a line." << endl;
+                }
+            } while (option < 1 || option > 4);
 
-            option = getValidIntegerInput();
-            if (option < 1 || option > 3) {
-                cout << "Invalid choice! Please enter 1 to compare more lines, 2 to return to main menu, or 3 to exit." << endl;
+            if (option == 4) {
+                editLineInSet(set);
             }
-        } while (option < 1 || option > 3);
+        } while (option == 4);
 
         if (option == 2) {
             clearScreen();
@@ -589,7 +1170,7 @@ void compareCustomLinesMenu() {
         }
         else if (option == 3) {
             cout << "Thank you for using our program!" << endl;
-            exit(0);
+            exitProgram();
         }
     }
 }
@@ -598,29 +1179,36 @@ void createCustomShapeMenu() {
     while (true) {
         displayHeader("Create Custom Shape");
 
-        vector<lineType> lines;
+        lineSet set;
         cout << "Enter coefficients for 4 lines to create a quadrilateral." << endl;
 
         for (int i = 1; i <= 4; i++) {
-            lines.push_back(getLineFromUser("line " + to_string(i)));
+            set.insertLine(i - 1, getLineFromUser("line " + to_string(i)));
         }
 
-        displayHeader("Shape Analysis Results");
-        showShape(lines);
-
         int option;
         do {
-            cout << "\nWhat would you like to do?" << endl;
-            cout << "1. Create another shape" << endl;
-            cout << "2. Return to main menu" << endl;
-            cout << "3. Exit program" << endl;
-            cout << "\nChoice: ";
+            displayHeader("Shape Analysis Results");
+            showShape(set);
+
+            do {
+                cout << "\nWhat would you like to do?" << endl;
+                cout << "1. Create another shape" << endl;
+                cout << "2. Return to main menu" << endl;
+                cout << "3. Exit program" << endl;
+                cout << "4. Change one of the lines" << endl;
+                cout << "\nChoice: ";
+
+                option = getValidIntegerInput();
+                if (option < 1 || option > 4) {
+                    cout << "Invalid choice! Please enter 1 to create another shape, 2 to return to main menu, 3 to exit, or 4 to change a line." << endl;
+                }
+            } while (option < 1 || option > 4);
 
-            option = getValidIntegerInput();
-            if (option < 1 || option > 3) {
-                cout << "Invalid choice! Please enter 1 to create another shape, 2 to return to main menu, or 3 to exit." << endl;
+            if (option == 4) {
+                editLineInSet(set);
             }
-        } while (option < 1 || option > 3);
+        } while (option == 4);
 
         if (option == 2) {
             clearScreen();
@@ -628,7 +1216,7 @@ void createCustomShapeMenu() {
         }
         else if (option == 3) {
             cout << "Thank you for using our program!" << endl;
-            exit(0);
+            exitProgram();
         }
     }
 }
@@ -639,120 +1227,39 @@ void checkQuadrilateral(const vector<lineType>& lines) {
         return;
     }
 
-    // Get all possible intersections first
-    vector<Point> allIntersections;
-    for (size_t i = 0; i < lines.size(); ++i) {
-        for (size_t j = i + 1; j < lines.size(); ++j) {
-            Point p = lines[i].findIntersectionPoint(lines[j]);
-            if (!isinf(p.x) && !isinf(p.y)) {
-                allIntersections.push_back(p);
-            }
-        }
-    }
-
-    // Reorder points to form the quadrilateral
-    vector<Point> orderedPoints;
-    if (allIntersections.size() >= 4) {
-        // Find the topmost point to start
-        int topmost = 0;
-        for (size_t i = 1; i < allIntersections.size(); i++) {
-            if (allIntersections[i].y > allIntersections[topmost].y) {
-                topmost = i;
-            }
-        }
-        orderedPoints.push_back(allIntersections[topmost]);
-
-        // Find remaining points based on proximity
-        vector<bool> used(allIntersections.size(), false);
-        used[topmost] = true;
-
-        for (int i = 0; i < 3; i++) {
-            double minDist = numeric_limits<double>::max();
-            int nextPoint = -1;
-
-            for (size_t j = 0; j < allIntersections.size(); j++) {
-                if (!used[j]) {
-                    double dist = calculateDistance(orderedPoints.back(), allIntersections[j]);
-                    if (dist < minDist) {
-                        minDist = dist;
-                        nextPoint = j;
-                    }
-                }
-            }
-
-            if (nextPoint != -1) {
-                orderedPoints.push_back(allIntersections[nextPoint]);
-                used[nextPoint] = true;
-            }
-        }
-    }
-
-    // Calculate side lengths using ordered points
-    vector<double> sideLengths;
-    if (orderedPoints.size() == 4) {
-        sideLengths.push_back(calculateDistance(orderedPoints[0], orderedPoints[1]));
-        sideLengths.push_back(calculateDistance(orderedPoints[1], orderedPoints[2]));
-        sideLengths.push_back(calculateDistance(orderedPoints[2], orderedPoints[3]));
-        sideLengths.push_back(calculateDistance(orderedPoints[3], orderedPoints[0]));
-    }
-
-    // Store original order for display
-    vector<double> originalLengths = sideLengths;
-    sort(sideLengths.begin(), sideLengths.end());
-
-    // Reorganize lines so parallel pairs are grouped correctly
-    vector<lineType> reorderedLines = lines;
-    if (!lines[0].isParallel(lines[2])) {
-        swap(reorderedLines[1], reorderedLines[2]);
+    printShapeReport(classifyQuadrilateral(lineRelations(lines), { 0, 1, 2, 3 }));
+}
+// The name of each shape, for short answers like the command mode gives
+string shapeName(shapeType type) {
+    switch (type) {
+    case shapeType::Square: return "square";
+    case shapeType::Rectangle: return "rectangle";
+    case shapeType::Rhombus: return "rhombus";
+    case shapeType::Parallelogram: return "parallelogram";
+    case shapeType::Trapezoid: return "trapezoid";
+    case shapeType::Irregular: return "irregular";
+    case shapeType::None: break;
     }
-
-    bool equalSides = (sideLengths.size() == 4) &&
-        (abs(sideLengths[0] - sideLengths[3]) < EPSILON);
-
-    bool equalOpposites = (sideLengths.size() == 4) &&
-        (abs(sideLengths[0] - sideLengths[1]) < EPSILON) &&
-        (abs(sideLengths[2] - sideLengths[3]) < EPSILON);
-
-    bool isParallelogram = reorderedLines[0].isParallel(reorderedLines[2]) &&
-        reorderedLines[1].isParallel(reorderedLines[3]);
-
-    bool isRectangle = reorderedLines[0].isPerpendicular(reorderedLines[1]) &&
-        reorderedLines[1].isPerpendicular(reorderedLines[2]) &&
-        reorderedLines[2].isPerpendicular(reorderedLines[3]) &&
-        reorderedLines[3].isPerpendicular(reorderedLines[0]) &&
-        isParallelogram &&
-        equalOpposites;
-
-    bool isRhombus = reorderedLines[0].isParallel(reorderedLines[2]) &&
-        reorderedLines[1].isParallel(reorderedLines[3]) &&
-        equalSides;
-
-    bool isSquare = reorderedLines[0].isPerpendicular(reorderedLines[1]) &&
-        reorderedLines[1].isPerpendicular(reorderedLines[2]) &&
-        reorderedLines[2].isPerpendicular(reorderedLines[3]) &&
-        reorderedLines[3].isPerpendicular(reorderedLines[0]) &&
-        isParallelogram &&
-        equalSides;
-
-    bool isTrapezoid = (reorderedLines[0].isParallel(reorderedLines[2]) &&
-        !reorderedLines[1].isParallel(reorderedLines[3])) ||
-        (reorderedLines[1].isParallel(reorderedLines[3]) &&
-            !reorderedLines[0].isParallel(reorderedLines[2]));
-
-    // Output results
+    return "none";
+}
+// Prints the side lengths and the kind of shape we found
+void printShapeReport(const shapeReport& report) {
     cout << "\nHere is the information about the shape you chose:" << endl;
-    if (sideLengths.size() == 4) {
+    if (report.sideLengths.size() == 4) {
         cout << "The sides lengths are: ";
-        for (double length : originalLengths) {
+        for (double length : report.sideLengths) {
             cout << fixed << setprecision(3) << length << " ";
         }
         cout << endl;
     }
 
-    if (isSquare) cout << "The shape you have chosen is a square! (all sides equal and all angles 90 degree)" << endl;
-    else if (isRectangle) cout << "The shape you have chosen is a rectangle! (opposite sides equal and all angles 90 degree)" << endl;
-    else if (isRhombus) cout << "The shape you have chosen is a rhombus! (all sides equal but angles aren't 90 degree)" << endl;
-    else if (isParallelogram) cout << "The shape you have chosen is a parallelogram! (opposite sides are equal and but angles aren't 90 degree)" << endl;
-    else if (isTrapezoid) cout << "The shape you have chosen is a trapezoid! (there is only one pair of parallel sides)" << endl;
-    else cout << "Looks like the shape you have chosen, is an irregular quadrilateral!" << endl;
+    switch (report.type) {
+    case shapeType::Square: cout << "The shape you have chosen is a square! (all sides equal and all angles 90 degree)" << endl; break;
+    case shapeType::Rectangle: cout << "The shape you have chosen is a rectangle! (opposite sides equal and all angles 90 degree)" << endl; break;
+    case shapeType::Rhombus: cout << "The shape you have chosen is a rhombus! (all sides equal but angles aren't 90 degree)" << endl; break;
+    case shapeType::Parallelogram: cout << "The shape you have chosen is a parallelogram! (opposite sides are equal and but angles aren't 90 degree)" << endl; break;
+    case shapeType::Trapezoid: cout << "The shape you have chosen is a trapezoid! (there is only one pair of parallel sides)" << endl; break;
+    case shapeType::Irregular: cout << "Looks like the shape you have chosen, is an irregular quadrilateral!" << endl; break;
+    case shapeType::None: cout << "Hey, we need exactly 4 lines to make a quadrilateral!" << endl; break;
+    }
 }
@@ -0,0 +1,267 @@
+#ifndef LINETYPE_H    
+#define LINETYPE_H    
+
+// This makes sure our C++ stuff works with C code if needed
+#ifdef __cplusplus
+extern "C++" {       
+#endif
+
+// Get the tools we need
+#include <vector>    // For storing lists of lines
+#include <string>    // For text handling
+#include <iostream>  // For input/output
+
+// A simple struct for points, x and y coordinates
+    struct Point {
+        double x, y;                                     
+        // Constructor, makes a point with or without coordinates
+
+        Point(double x = 0, double y = 0) : x(x), y(y) {} 
+    };
+
+    // This is our drawing canvas, where we can draw our lines and shapes using ASCII characters
+    struct Canvas {
+        static const int WIDTH = 70;    // How wide our canvas is
+        static const int HEIGHT = 30;   // How tall our canvas is
+        char grid[HEIGHT][WIDTH];       // The actual grid we draw on, like pixels
+        double xMin, xMax, yMin, yMax;  // The boundaries of what we can see
+
+        // Things that canvas can do:
+        Canvas();        // Creates a new blank canvas
+        void clear();    // Wipes the canvas clean
+        void plotSegment(const Point& start, const Point& end, char symbol);  // Draws a line segment
+        void plotPoint(double x, double y, char symbol);                      // Plots a single point
+        void plotLine(const class lineType& line, char symbol);              // Draws a whole line
+        void plotIntersection(const Point& p, const std::string& label);     // Marks where lines cross
+        void autoScale(const std::vector<class lineType>& lines);            // Adjusts view to fit lines
+        void display(std::ostream& out = std::cout) const;                   // Shows the canvas
+    };
+
+    // Our main class for handling lines
+    class lineType {
+    private:
+        // These are the coefficients in ax + by = c
+        double a, b, c;
+
+    public:
+        // Makes a new line with given coefficients
+        lineType(double a, double b, double c);    // Makes a new line
+           // Functions to get our a, b, c values
+        double getA() const;     
+        double getB() const;       
+        double getC() const;       
+           // Gets the slope of the line (-a/b in our format)
+        double getSlope() const;   
+
+        // Checks if lines are parallel or perpendicular
+        bool isParallel(const lineType& other) const;          
+        bool isPerpendicular(const lineType& other) const;     
+        // Finds where two lines intersect
+        Point findIntersectionPoint(const lineType& other) const;  
+    };
+
+    // How lineType decides if lines are parallel, perpendicular or crossing
+    enum class precisionMode {
+        Epsilon,    // The original tests, slopes compared within a fixed 1e-9
+        Adaptive,   // Angle based tests that fall back to exact arithmetic when it's too close to call
+        Exact       // Same answers as Adaptive but always using the exact arithmetic, for checking
+    };
+    void setPrecisionMode(precisionMode mode);   // Picks the mode for every test from now on
+    precisionMode getPrecisionMode();            // Which mode we're in
+
+    // How many adaptive tests were settled by the quick check and how many needed exact arithmetic
+    struct predicateCounters {
+        unsigned long long fastPath = 0;
+        unsigned long long exactPath = 0;
+    };
+    predicateCounters getPredicateCounters();
+    void printPredicateCounters(std::ostream& out);   // "Adaptive tests: ...", nothing in Epsilon mode
+    [[noreturn]] void exitProgram();     // Prints the counters and ends the program, for the menus
+
+    // Everything about how the lines in a set relate, worked out once for every pair.
+    // Bit j of parallelMask[i] is set when lines i and j are parallel, same for perpendicular,
+    // and crossings[i][j] is where they intersect (infinity if they don't).
+    struct lineRelations {
+        static const int MAX_LINES = 64;    // One bit per line in each mask
+
+        std::vector<unsigned long long> parallelMask;
+        std::vector<unsigned long long> perpendicularMask;
+        std::vector<std::vector<Point>> crossings;
+
+        lineRelations() {}                                          // No lines yet
+        explicit lineRelations(const std::vector<lineType>& lines);  // Checks every pair once
+
+        int size() const;
+        bool isParallel(int i, int j) const;
+        bool isPerpendicular(int i, int j) const;
+        Point intersection(int i, int j) const;
+
+        // Keeping up with edits, each of these only touches the pairs with one line in them
+        void appendLine(const std::vector<lineType>& lines);             // lines.back() is the new one
+        void updateLine(int index, const std::vector<lineType>& lines);  // lines[index] changed
+        void removeLine(int index);    // The last line moves into index, like we do with the lines
+    };
+
+    // All the kinds of shapes we can recognise, None means we didn't have 4 lines
+    enum class shapeType { None, Square, Rectangle, Rhombus, Parallelogram, Trapezoid, Irregular };
+
+    // What we found out about a shape, its type and side lengths (in drawing order)
+    struct shapeReport {
+        shapeType type = shapeType::None;
+        std::vector<double> sideLengths;
+    };
+
+    // A set of lines we can edit one line at a time. It keeps a lineRelations for its lines,
+    // so changing one line only recomputes the pairs that line is part of.
+    class lineSet {
+    public:
+        static const int MAX_LINES = lineRelations::MAX_LINES;
+
+        lineSet();                                          // Makes an empty set
+        explicit lineSet(const std::vector<lineType>& lines);  // Makes a set from some lines
+
+        // Getting lines back out, indexes are positions in the set (0 is the first line)
+        int size() const;
+        const lineType& line(int index) const;
+        std::vector<lineType> lines() const;
+
+        // Editing the set, these return false if the index is bad or the set is full
+        bool replaceLine(int index, const lineType& line);
+        bool insertLine(int index, const lineType& line);
+        bool removeLine(int index);
+
+        // Cached answers about a pair of lines
+        bool isParallel(int i, int j) const;
+        bool isPerpendicular(int i, int j) const;
+        Point intersection(int i, int j) const;
+
+        // The relations themselves, positions() says which relation index each position uses
+        const lineRelations& relations() const;
+        const std::vector<int>& positions() const;
+
+        // The shape the first 4 lines make, kept up to date after every edit
+        const shapeReport& classification() const;
+
+    private:
+        std::vector<lineType> slots;     // The lines, in whatever slot they landed in
+        std::vector<int> order;          // Which slot holds the line at each position
+        lineRelations pairs;             // How every two slots relate
+        shapeReport report;              // Classification of the current lines
+    };
+
+    // Screen handling functions
+    void clearScreen();     // Clears the screen
+    void pauseScreen();     // Waits for user to press Enter
+
+    void displayHeader(const std::string& title);  // Shows pretty menu headers
+    int getValidIntegerInput();    // Makes sure user types actual numbers
+    double calculateDistance(const Point& p1, const Point& p2);  // Finds distance between points
+    void displayVisualization(const std::vector<lineType>& lines);  // Shows lines visually
+    void displayVisualization(const lineRelations& relations, const std::vector<int>& order,
+        std::ostream& out = std::cout);                                 // Same, from relations
+
+    // Functions for analyzing lines:
+    void findIntersection(const lineType& line1, const lineType& line2);  // Finds crossing point
+    void checkLines(const lineType& line1, const lineType& line2);        // Analyzes line relationships
+    void checkLines(const lineType& line1, const lineType& line2,
+        const lineRelations& relations, int index1, int index2);         // Same, with the answers already worked out
+
+    // Functions for analyzing shapes:
+    void showShape(const std::vector<lineType>& lines);         // Shows shape properties
+    void showShape(const lineSet& set);                          // Same, using a set's cached answers
+    void checkQuadrilateral(const std::vector<lineType>& lines);  // Identifies shape type
+    void printShapeReport(const shapeReport& report);            // Prints what kind of shape we found
+    std::string shapeName(shapeType type);                       // "square", "trapezoid", ...
+    shapeReport classifyQuadrilateral(const lineRelations& relations, const std::vector<int>& order);  // Works out the shape
+
+    // Menu functions that handle user interaction:
+    void compareLinesMenu(const std::vector<std::vector<lineType>>& allLines);  // For comparing lines
+    void showShapesMenu(const std::vector<std::vector<lineType>>& allLines);    // For analyzing shapes
+    void compareCustomLinesMenu();    // For comparing user's own lines
+    void createCustomShapeMenu();     // For creating user's own shapes
+    lineType getLineFromUser(const std::string& lineNumber);    // Gets line input from user
+    void editLineInSet(lineSet& set);    // Lets the user swap one line of a set for a new one
+
+    // Reads sets of 4 lines (a b c for each) until the stream runs out, false if the last set isn't complete
+    bool loadLineSets(std::istream& in, std::vector<std::vector<lineType>>& allLines);
+    enum class setReadResult { Found, NoMore, Unfinished };
+    setReadResult readLineSet(const std::string& text, size_t& pos,
+        std::vector<lineType>& lines);     // One set at pos, the number reading every loader shares
+
+    // Command mode, for scripts: one query per line in, one answer per query out (commands.cpp).
+    // Every answer starts with "ok" or "error"; "ok lines N" means N more lines of answer follow.
+    struct commandSession {
+        int currentSet = -1;    // The set "use set N" picked, -1 if none yet
+    };
+    bool runCommand(const std::string& command, const std::vector<lineSet>& sets,
+        commandSession& session, std::ostream& out);    // Answers one query, false means "quit"
+    void runCommandMode(std::istream& in, std::ostream& out,
+        const std::vector<std::vector<lineType>>& allLines);    // Answers queries until the input ends
+
+    // Server mode: the sets stay loaded and analyzed, and any number of clients can send the same
+    // queries as command mode over a Unix domain socket (server.cpp)
+    int runServer(const std::string& socketPath, const std::vector<std::vector<lineType>>& allLines,
+        int workerCount);                        // Serves until Ctrl+C, workerCount 0 means one per CPU
+    int runClient(const std::string& socketPath);    // Sends stdin to a server and prints the answers
+
+    // A lines file kept loaded and analyzed. refresh() catches up with edits by reparsing only the
+    // part of the file that changed and reclassifying only the sets that came out different (watch.cpp)
+    struct refreshSummary {
+        bool fileReadable = true;     // false if the file couldn't be opened
+        bool complete = true;         // false if a set stops partway, then nothing was changed
+        std::vector<int> changedSets; // Sets whose lines are different now (including new ones)
+        int removedSets = 0;          // How many sets disappeared off the end
+        size_t bytesParsed = 0;       // How much text we actually had to parse again
+    };
+    class lineFile {
+    public:
+        refreshSummary load(const std::string& path);   // Reads and analyzes the whole file
+        refreshSummary refresh();                // Catches up with whatever changed since last time
+
+        const std::vector<std::vector<lineType>>& lines() const;  // Same layout as main's allLines
+        const std::vector<lineSet>& sets() const;                 // Each set, analyzed
+        const std::string& path() const;
+
+    private:
+        std::string filePath;
+        std::string text;                        // The file as we last read it
+        std::vector<std::vector<lineType>> allLines;
+        std::vector<lineSet> analyzed;
+        std::vector<size_t> setStart, setEnd;    // Where each set's first number starts and last number ends
+
+        // Reads whole sets of 4 lines from text starting at pos, see watch.cpp for when it stops
+        size_t parseSets(const std::string& source, size_t pos, size_t resyncAfter, long long shift,
+            int firstOldSet, std::vector<std::vector<lineType>>& found, std::vector<size_t>& starts,
+            std::vector<size_t>& ends, int& resyncSet, bool& unfinished) const;
+    };
+    int runWatchMode(const std::string& path);   // Prints what changes every time the file does
+
+    // Measurements of the shape a set makes, all worked out in one go from its 4 corners (metrics.cpp)
+    struct polygonMetrics {
+        bool valid = false;         // false if the lines don't close up into 4 corners
+        double area = 0;            // Half the cross product of the diagonals
+        double perimeter = 0;
+        double sides[4] = {};       // Corner 1 to 2, 2 to 3, 3 to 4 and 4 back to 1, going counterclockwise
+        double angles[4] = {};      // Interior angle at each corner, in degrees
+        double diagonals[2] = {};   // Corner 1 to 3 and corner 2 to 4
+        Point centroid;             // Center of mass of the shape (not just the average corner). The corners
+                                    // come from findIntersectionPoint, which gives -x, -y for ax + by = c
+                                    // lines, so this is mirrored the same way: x = -4, x = -2, y = -8, y = -2
+                                    // gives 3, 5, not -3, -5
+    };
+    polygonMetrics measurePolygon(const std::vector<Point>& corners);   // Needs exactly 4 corners, in order round the shape
+    polygonMetrics measureSet(const lineSet& set);                      // Corners from the set's cached crossings
+    std::vector<polygonMetrics> measureSets(const std::vector<lineSet>& sets,
+        int threadCount);                        // Every set, split over threads (0 means one per CPU)
+    void printMetrics(const polygonMetrics& metrics, std::ostream& out);  // "area ... centroid x y" or "none"
+
+    // Self checking: random and nasty line sets, fast code checked against slow references (fuzz.cpp)
+    int runFuzzHarness(unsigned long long cases, unsigned long long seed);  // Returns how many cases failed
+
+    // End of C++ specific code
+#ifdef __cplusplus
+}
+#endif
+
+// End of include guard
+#endif
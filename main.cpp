@@ -3,46 +3,178 @@
 #include <iostream>     // For input/output
 #include <vector>       // For storing our lines
 #include <limits>       // For some number limits
+#include <string>       // For reading command line options
+#include <cstdlib>      // For strtoull
+#include <cctype>       // For isdigit
+#include <cerrno>       // For spotting numbers that are too big
 
 // Let the compiler know these functions exist
 void compareCustomLinesMenu();
 void createCustomShapeMenu();
 
-int main() {
+// Reads a whole number from a command line option, false if it isn't one (like "abc" or "-3")
+bool readOptionNumber(const char* text, unsigned long long& value) {
+   if (!std::isdigit(static_cast<unsigned char>(text[0]))) return false;
+   char* end;
+   errno = 0;
+   value = std::strtoull(text, &end, 10);
+   return *end == '\0' && errno == 0;
+}
+
+int main(int argc, char* argv[]) {
+   // Command line options, --adaptive switches to the scale aware parallel/perpendicular tests,
+   // --exact does the same tests always with exact arithmetic, and --fuzz N checks N random cases.
+   // --commands [FILE] answers queries from FILE (or typed in) instead of showing menus,
+   // and --data FILE reads the lines from FILE instead of linesData.txt.
+   // --serve SOCKET keeps the sets loaded and answers queries on a Unix socket (--workers N threads),
+   // and --client SOCKET sends our input to a running server.
+   // --watch keeps an eye on the data file and reports the sets that change whenever it's saved,
+   // and --metrics prints area, perimeter, angles, diagonals and centroid for every set (--workers N threads,
+   // the centroid is mirrored like findIntersectionPoint, see polygonMetrics)
+   unsigned long long fuzzCases = 0;
+   unsigned long long fuzzSeed = 1;
+   bool commandMode = false;
+   std::string commandFile;
+   std::string dataFile = "linesData.txt";
+   std::string serveSocket;
+   std::string clientSocket;
+   int workerCount = 0;
+   bool watchMode = false;
+   bool metricsMode = false;
+   for (int i = 1; i < argc; ++i) {
+       std::string option = argv[i];
+       if (option == "--adaptive") {
+           setPrecisionMode(precisionMode::Adaptive);
+       }
+       else if (option == "--exact") {
+           setPrecisionMode(precisionMode::Exact);
+       }
+       else if (option == "--fuzz" && i + 1 < argc) {
+           if (!readOptionNumber(argv[++i], fuzzCases)) {
+               std::cerr << "Invalid number for --fuzz: " << argv[i] << std::endl;
+               return 1;
+           }
+       }
+       else if (option == "--seed" && i + 1 < argc) {
+           if (!readOptionNumber(argv[++i], fuzzSeed)) {
+               std::cerr << "Invalid number for --seed: " << argv[i] << std::endl;
+               return 1;
+           }
+       }
+       else if (option == "--commands") {
+           commandMode = true;
+           if (i + 1 < argc && std::string(argv[i + 1]).compare(0, 2, "--") != 0) {
+               commandFile = argv[++i];
+           }
+       }
+       else if (option == "--data" && i + 1 < argc) {
+           dataFile = argv[++i];
+       }
+       else if (option == "--serve" && i + 1 < argc) {
+           serveSocket = argv[++i];
+       }
+       else if (option == "--workers" && i + 1 < argc) {
+           unsigned long long workers;
+           if (!readOptionNumber(argv[++i], workers) || workers > 1024) {
+               std::cerr << "Invalid number for --workers: " << argv[i] << std::endl;
+               return 1;
+           }
+           workerCount = static_cast<int>(workers);
+       }
+       else if (option == "--client" && i + 1 < argc) {
+           clientSocket = argv[++i];
+       }
+       else if (option == "--watch") {
+           watchMode = true;
+       }
+       else if (option == "--metrics") {
+           metricsMode = true;
+       }
+       else {
+           std::cerr << "Unknown option: " << option << std::endl;
+           return 1;
+       }
+   }
+
+   // Fuzzing doesn't need the data file, it makes up its own lines
+   if (fuzzCases > 0) {
+       return runFuzzHarness(fuzzCases, fuzzSeed) == 0 ? 0 : 1;
+   }
+
+   // The client just passes queries along, the server has the data
+   if (!clientSocket.empty()) {
+       return runClient(clientSocket);
+   }
+
+   // Watch mode reads the file itself so it can tell which parts changed later
+   // The modes below print the adaptive counts when they finish, like the menus do on exit.
+   // They go to cerr so scripts reading the answers on cout don't see them.
+   if (watchMode) {
+       int result = runWatchMode(dataFile);
+       printPredicateCounters(std::cerr);
+       return result;
+   }
+
    // Open file and makes sure this file should have sets of lines (4 lines per set)
-   std::ifstream inputFile("linesData.txt");
+   std::ifstream inputFile(dataFile);
    if (!inputFile) {
        std::cerr << "Error opening file." << std::endl;  
        return 1;
    }
 
-   // This stores all our sets of lines
+   // This stores all our sets of lines, read 4 lines at a time
    std::vector<std::vector<lineType>> allLines;
+   if (!loadLineSets(inputFile, allLines)) {
+       std::cerr << "Insufficient data for set." << std::endl;
+       return 1;
+   }
 
-   // Variables for line coefficients (ax + by = c)
-   double a, b, c;
+   inputFile.close();
 
-   // Read lines from file, 4 at a time
-   while (inputFile >> a >> b >> c) {  // Read first line of a set
-       std::vector<lineType> lines;  // Make a new set
-       lines.push_back(lineType(a, b, c));  // Add first line
+   // Metrics mode measures every set at once and prints them in file order
+   if (metricsMode) {
+       std::vector<lineSet> sets;
+       for (const std::vector<lineType>& lines : allLines) {
+           sets.push_back(lineSet(lines));
+       }
+       std::vector<polygonMetrics> metrics = measureSets(sets, workerCount);
+       for (size_t i = 0; i < metrics.size(); ++i) {
+           std::cout << "Set " << (i + 1) << ": ";
+           printMetrics(metrics[i], std::cout);
+           std::cout << "\n";
+       }
+       std::cout << std::flush;
+       printPredicateCounters(std::cerr);
+       return 0;
+   }
 
-       // Read 3 more lines to complete the set
-       for (int i = 1; i < 4; ++i) {
-           if (inputFile >> a >> b >> c) {
-               lines.push_back(lineType(a, b, c));
-           }
-           else {
-               std::cerr << "Insufficient data for set." << std::endl;
+   // Server mode runs until it's stopped
+   if (!serveSocket.empty()) {
+       int result = runServer(serveSocket, allLines, workerCount);
+       printPredicateCounters(std::cerr);
+       return result;
+   }
+
+   // Command mode skips the menus completely, scripts talk to it one query per line
+   if (commandMode) {
+       std::ios::sync_with_stdio(false);   // Lets us see how much input is already waiting
+       std::cin.tie(nullptr);
+       if (commandFile.empty()) {
+           runCommandMode(std::cin, std::cout, allLines);
+       }
+       else {
+           std::ifstream commands(commandFile);
+           if (!commands) {
+               std::cerr << "Error opening command file." << std::endl;
                return 1;
            }
+           runCommandMode(commands, std::cout, allLines);
        }
-       // Add completed set to our collection
-       allLines.push_back(lines);
+       std::cout << std::flush;
+       printPredicateCounters(std::cerr);
+       return 0;
    }
 
-   inputFile.close();
-
    // Main program loop 
    while (true) {
        // Shows the main menu
@@ -74,7 +206,7 @@ int main() {
        case 5:  // Exits program
            clearScreen();
            std::cout << "Thank you for using the program!" << std::endl;
-           return 0;
+           exitProgram();
        default:  
            std::cout << "Invalid option. Please choose again." << std::endl;
            pauseScreen();
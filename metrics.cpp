@@ -0,0 +1,242 @@
+#include "linetype.h"      // Our line and shape code
+#include <iostream>        // For output
+#include <iomanip>        // For 3 decimal places
+#include <vector>         // For storing corners and results
+#include <cmath>          // For sqrt, hypot and atan2
+#include <algorithm>      // For min, max and swap
+#include <thread>         // For measuring lots of sets at once
+
+using namespace std;      // So we don't have to write std:: all the time
+
+const double DEGREES_PER_RADIAN = 180.0 / 3.14159265358979323846;
+const double FLAT_SHAPE = 1e-9;    // Area this small next to the perimeter squared counts as flat, same cutoff as EPSILON
+
+// How many shapes get measured together, see cornerBlock
+const int BLOCK = 64;
+
+// A block of shapes laid out one array per corner coordinate, so position i of every array is shape i.
+// That way the measuring loop does the same sums for shape after shape, and the compiler can work on
+// several shapes per instruction instead of one corner at a time.
+struct cornerBlock {
+    double x[4][BLOCK];
+    double y[4][BLOCK];
+};
+
+// Finds the corners of the shape the lines enclose. Every line is one side, and its two corners are
+// where it crosses the sides next to it; the side opposite it is the one it never meets at a corner, so
+// parallel lines can only be opposite sides. Of the 3 ways to pick opposite pairs only one gives a
+// convex shape, the others give a dart or a bow tie that cut through it. False if no pairing closes up
+// (like a trapezoid whose slanted sides cross between the parallel ones). The corners come back in
+// order going counterclockwise.
+static bool findCorners(const lineRelations& relations, const vector<int>& order, Point corners[4]) {
+    if (order.size() != 4) return false;
+
+    // Each row goes round the sides in order, so opposite sides are 2 apart
+    const int pairings[3][4] = { { 0, 2, 1, 3 }, { 0, 1, 2, 3 }, { 0, 1, 3, 2 } };
+    for (const int* sides : pairings) {
+        bool closes = true;
+        for (int k = 0; k < 4 && closes; k++) {
+            int line = order[sides[k]];
+            int next = order[sides[(k + 1) & 3]];
+            if (relations.isParallel(line, next)) closes = false;
+            else corners[k] = relations.intersection(line, next);
+            if (closes && (!isfinite(corners[k].x) || !isfinite(corners[k].y))) closes = false;
+        }
+        if (!closes) continue;
+
+        // Convex means we turn the same way at every corner, the same way the shape goes round.
+        // Not turning at all means two corners are the same point (3 lines meet there), and that's
+        // a triangle, not a 4 sided shape. The sums are the same ones measureBlock does, so it sees
+        // the same turns we did here.
+        int left = 0, right = 0;
+        double perimeter = 0;
+        for (int k = 0; k < 4; k++) {
+            const Point& p = corners[k];
+            const Point& q = corners[(k + 1) & 3];
+            const Point& r = corners[(k + 2) & 3];
+            double turn = (q.x - p.x) * (r.y - q.y) - (q.y - p.y) * (r.x - q.x);
+            if (turn > 0) left++;
+            if (turn < 0) right++;
+            perimeter += hypot(q.x - p.x, q.y - p.y);
+        }
+        double twiceArea = (corners[2].x - corners[0].x) * (corners[3].y - corners[1].y) -
+            (corners[2].y - corners[0].y) * (corners[3].x - corners[1].x);
+        if (!(left == 4 && twiceArea > 0) && !(right == 4 && twiceArea < 0)) continue;
+
+        // Two sides on (nearly) the same line give a flat sliver, nothing worth measuring
+        if (abs(twiceArea) <= FLAT_SHAPE * perimeter * perimeter) continue;
+
+        // Going round the sides already visits the corners in order, just make it counterclockwise.
+        // (Sorting by angle around the mean gives the same order, but for a long thin shape the
+        // angles can round to the same number and come out shuffled.)
+        if (twiceArea < 0) swap(corners[1], corners[3]);
+        return true;
+    }
+    return false;
+}
+
+// Measures the first count shapes of a block. The first loop is plain arithmetic with no branches
+// or calls and always runs over the whole block, so the compiler turns it into vector instructions
+// (g++ does at -O2). sqrt and atan2 are library calls that may set errno, which would stop that,
+// so they're left for the second loop.
+static void measureBlock(const cornerBlock& block, int count, polygonMetrics* results) {
+    double squaredSide[4][BLOCK], squaredDiagonal[2][BLOCK];
+    double turnSin[4][BLOCK], turnCos[4][BLOCK];
+    double twiceArea[BLOCK], centerX[BLOCK], centerY[BLOCK];
+
+    for (int i = 0; i < BLOCK; i++) {
+        double x0 = block.x[0][i], x1 = block.x[1][i], x2 = block.x[2][i], x3 = block.x[3][i];
+        double y0 = block.y[0][i], y1 = block.y[1][i], y2 = block.y[2][i], y3 = block.y[3][i];
+
+        // The sides, going round: corner 0 to 1, 1 to 2, 2 to 3, 3 back to 0. Each one is taken
+        // straight from its own two corners, so a long side can't swamp a short one next to it.
+        double edgeX0 = x1 - x0, edgeX1 = x2 - x1, edgeX2 = x3 - x2, edgeX3 = x0 - x3;
+        double edgeY0 = y1 - y0, edgeY1 = y2 - y1, edgeY2 = y3 - y2, edgeY3 = y0 - y3;
+        squaredSide[0][i] = edgeX0 * edgeX0 + edgeY0 * edgeY0;
+        squaredSide[1][i] = edgeX1 * edgeX1 + edgeY1 * edgeY1;
+        squaredSide[2][i] = edgeX2 * edgeX2 + edgeY2 * edgeY2;
+        squaredSide[3][i] = edgeX3 * edgeX3 + edgeY3 * edgeY3;
+
+        // How far we turn at each corner, from the side coming in to the side going out
+        turnSin[0][i] = edgeX3 * edgeY0 - edgeY3 * edgeX0;
+        turnCos[0][i] = edgeX3 * edgeX0 + edgeY3 * edgeY0;
+        turnSin[1][i] = edgeX0 * edgeY1 - edgeY0 * edgeX1;
+        turnCos[1][i] = edgeX0 * edgeX1 + edgeY0 * edgeY1;
+        turnSin[2][i] = edgeX1 * edgeY2 - edgeY1 * edgeX2;
+        turnCos[2][i] = edgeX1 * edgeX2 + edgeY1 * edgeY2;
+        turnSin[3][i] = edgeX2 * edgeY3 - edgeY2 * edgeX3;
+        turnCos[3][i] = edgeX2 * edgeX3 + edgeY2 * edgeY3;
+
+        // The shoelace sum for 4 corners works out to the cross product of the two diagonals
+        double diagonalX0 = x2 - x0, diagonalY0 = y2 - y0;
+        double diagonalX1 = x3 - x1, diagonalY1 = y3 - y1;
+        squaredDiagonal[0][i] = diagonalX0 * diagonalX0 + diagonalY0 * diagonalY0;
+        squaredDiagonal[1][i] = diagonalX1 * diagonalX1 + diagonalY1 * diagonalY1;
+        twiceArea[i] = diagonalX0 * diagonalY1 - diagonalY0 * diagonalX1;
+
+        // Centroid: cut along the first diagonal into two triangles and weigh each triangle's center
+        // by its share of the area. Shares instead of areas keep huge shapes from overflowing.
+        double triangle1 = edgeX0 * diagonalY0 - edgeY0 * diagonalX0;
+        double triangle2 = diagonalY0 * edgeX3 - diagonalX0 * edgeY3;
+        double share1 = triangle1 / (triangle1 + triangle2);
+        double share2 = 1 - share1;
+        centerX[i] = (share1 * (edgeX0 + diagonalX0) + share2 * (diagonalX0 - edgeX3)) / 3;
+        centerY[i] = (share1 * (edgeY0 + diagonalY0) + share2 * (diagonalY0 - edgeY3)) / 3;
+    }
+
+    for (int i = 0; i < count; i++) {
+        polygonMetrics& metrics = results[i];
+        metrics.perimeter = 0;
+        for (int k = 0; k < 4; k++) {
+            metrics.sides[k] = sqrt(squaredSide[k][i]);
+            metrics.perimeter += metrics.sides[k];
+        }
+        metrics.diagonals[0] = sqrt(squaredDiagonal[0][i]);
+        metrics.diagonals[1] = sqrt(squaredDiagonal[1][i]);
+        metrics.area = abs(twiceArea[i]) / 2;
+
+        // Going round clockwise the turns are the other way, so flip them. A corner where the shape
+        // doubles straight back can come out as 360, that's really a spike with a 0 degree angle.
+        double direction = twiceArea[i] < 0 ? -1.0 : 1.0;
+        for (int k = 0; k < 4; k++) {
+            double angle = 180.0 - direction * atan2(turnSin[k][i], turnCos[k][i]) * DEGREES_PER_RADIAN;
+            metrics.angles[k] = angle >= 360.0 ? angle - 360.0 : angle;
+        }
+
+        // A flat shape has no real center of mass, so use the average corner instead
+        double cornerX = block.x[0][i], cornerY = block.y[0][i];
+        if (abs(twiceArea[i]) <= FLAT_SHAPE * metrics.perimeter * metrics.perimeter) {
+            metrics.centroid = Point(cornerX + (block.x[1][i] + block.x[2][i] + block.x[3][i] - 3 * cornerX) / 4,
+                cornerY + (block.y[1][i] + block.y[2][i] + block.y[3][i] - 3 * cornerY) / 4);
+        }
+        else {
+            metrics.centroid = Point(cornerX + centerX[i], cornerY + centerY[i]);
+        }
+        metrics.valid = true;
+    }
+}
+
+// Measures 4 corners given in order round the shape
+polygonMetrics measurePolygon(const vector<Point>& corners) {
+    polygonMetrics metrics;
+    if (corners.size() != 4) return metrics;
+
+    cornerBlock block = {};
+    for (int k = 0; k < 4; k++) {
+        block.x[k][0] = corners[k].x;
+        block.y[k][0] = corners[k].y;
+    }
+    measureBlock(block, 1, &metrics);
+    return metrics;
+}
+
+// Measures the shape a set's lines enclose, using the crossings the set already worked out
+polygonMetrics measureSet(const lineSet& set) {
+    Point corners[4];
+    if (!findCorners(set.relations(), set.positions(), corners)) return polygonMetrics();
+    return measurePolygon(vector<Point>(corners, corners + 4));
+}
+
+// Measures sets [from, to) a block at a time: find the corners of a block's worth of sets,
+// measure the whole block in one go, then hand out the answers
+static void measureRange(const vector<lineSet>& sets, size_t from, size_t to, vector<polygonMetrics>& results) {
+    cornerBlock block = {};
+    size_t owner[BLOCK];
+    polygonMetrics measured[BLOCK];
+    while (from < to) {
+        int count = 0;
+        for (; from < to && count < BLOCK; from++) {
+            Point corners[4];
+            if (!findCorners(sets[from].relations(), sets[from].positions(), corners)) {
+                results[from] = polygonMetrics();
+                continue;
+            }
+            for (int k = 0; k < 4; k++) {
+                block.x[k][count] = corners[k].x;
+                block.y[k][count] = corners[k].y;
+            }
+            owner[count++] = from;
+        }
+        measureBlock(block, count, measured);
+        for (int i = 0; i < count; i++) {
+            results[owner[i]] = measured[i];
+        }
+    }
+}
+
+// Measures every set. Each thread gets its own run of sets and writes only its own results,
+// so the threads never have to wait for each other.
+vector<polygonMetrics> measureSets(const vector<lineSet>& sets, int threadCount) {
+    vector<polygonMetrics> results(sets.size());
+    if (threadCount < 1) threadCount = max(1u, thread::hardware_concurrency());
+
+    // Starting a thread costs more than measuring a few sets, so small jobs use fewer threads
+    const size_t MIN_SETS_PER_THREAD = 1024;
+    size_t useThreads = min(static_cast<size_t>(threadCount), max(static_cast<size_t>(1), sets.size() / MIN_SETS_PER_THREAD));
+    size_t chunk = (sets.size() + useThreads - 1) / useThreads;
+
+    vector<thread> threads;
+    for (size_t t = 1; t < useThreads; t++) {
+        threads.emplace_back(measureRange, cref(sets), min(sets.size(), t * chunk),
+            min(sets.size(), (t + 1) * chunk), ref(results));
+    }
+    measureRange(sets, 0, min(sets.size(), chunk), results);    // This thread does the first run itself
+    for (thread& worker : threads) {
+        worker.join();
+    }
+    return results;
+}
+
+// Writes the measurements on one line, or "none" if the lines don't make a shape
+void printMetrics(const polygonMetrics& metrics, ostream& out) {
+    if (!metrics.valid) {
+        out << "none";
+        return;
+    }
+    out << fixed << setprecision(3) << "area " << metrics.area << " perimeter " << metrics.perimeter << " angles";
+    for (double angle : metrics.angles) {
+        out << " " << angle;
+    }
+    out << " diagonals " << metrics.diagonals[0] << " " << metrics.diagonals[1]
+        << " centroid " << metrics.centroid.x << " " << metrics.centroid.y;
+}
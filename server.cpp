@@ -0,0 +1,470 @@
+#include "linetype.h"      // Our line and shape code
+#include <iostream>        // For input/output
+#include <sstream>        // For collecting answers
+#include <string>         // For text manipulation
+#include <vector>         // For storing our sets
+#include <map>            // For looking up connections
+#include <memory>         // For unique_ptr
+#include <deque>          // For the job and result queues
+#include <thread>         // For the worker pool
+#include <mutex>          // For guarding the queues
+#include <condition_variable>  // For waking up idle workers
+#include <algorithm>      // For max and remove_if
+#include <atomic>         // For telling a worker its client has gone
+
+#ifndef _WIN32
+#include <sys/socket.h>   // For sockets
+#include <sys/un.h>       // For Unix domain socket addresses
+#include <sys/stat.h>     // For checking what's already at the socket path
+#include <sys/epoll.h>    // For the event loop
+#include <sys/eventfd.h>  // For workers to wake up the event loop
+#include <poll.h>         // For the client's little loop
+#include <unistd.h>       // For read, write, close
+#include <fcntl.h>        // For non-blocking sockets
+#include <csignal>        // For stopping cleanly on Ctrl+C
+#include <cerrno>         // For EAGAIN and friends
+#include <cstring>        // For strerror
+#endif
+
+using namespace std;      // So we don't have to write std:: all the time
+
+#ifndef _WIN32
+
+// Set by Ctrl+C or kill, the event loop checks it every time it wakes up
+static volatile sig_atomic_t stopRequested = 0;
+static void requestStop(int) { stopRequested = 1; }
+
+// Limits so one chatty client can't eat all our memory: we stop reading from a client once this much
+// of its input is waiting, and stop handing its queries to workers while this many answers are unsent.
+// A worker also stops a batch once it has this many answers, the rest of the queries wait their turn.
+static const size_t MAX_PENDING_INPUT = 1 << 20;
+static const size_t MAX_PENDING_OUTPUT = 1 << 20;
+static const size_t MAX_BATCH_INPUT = 1 << 16;
+
+// Everything we know about one connected client
+struct connection {
+    int fd = -1;
+    string input;              // Bytes read that aren't a whole query yet, or are waiting their turn
+    string output;             // Answers not written to the socket yet
+    commandSession session;    // "use set N" for this client
+    bool busy = false;         // A worker is running a batch of this client's queries
+    bool quitting = false;     // Client said "quit", close once its answers are sent
+    bool inputClosed = false;  // Client has sent everything, close once it's all answered
+    bool hungUp = false;       // Client went away, drop it once its worker (if any) is done
+    atomic<bool> abandoned{ false };  // Set when it hangs up mid batch, so the worker can stop early
+};
+
+// A batch of queries from one client, and what came back
+struct serverJob {
+    unsigned long long id;
+    commandSession* session;
+    const atomic<bool>* abandoned;
+    string commands;           // Whole queries, each ending in a newline
+};
+struct serverResult {
+    unsigned long long id;
+    string answers;
+    string unfinished;         // Queries we didn't get to because the answers got too big
+    bool quit;
+};
+
+// The worker pool: the event loop pushes jobs, workers run them and push results back,
+// then poke the eventfd so the loop knows there's something to send
+class workerPool {
+public:
+    workerPool(const vector<lineSet>& sets, int wakeFd, int count) : sets(sets), wakeFd(wakeFd) {
+        for (int i = 0; i < count; i++) {
+            threads.push_back(thread([this]() { work(); }));
+        }
+    }
+
+    ~workerPool() {
+        {
+            lock_guard<mutex> lock(jobsLock);
+            stopping = true;
+        }
+        jobsReady.notify_all();
+        for (thread& t : threads) {
+            t.join();
+        }
+    }
+
+    void submit(serverJob job) {
+        {
+            lock_guard<mutex> lock(jobsLock);
+            jobs.push_back(move(job));
+        }
+        jobsReady.notify_one();
+    }
+
+    // Takes a client's batch back out of the queue if no worker has started it, true if it was there
+    bool cancel(unsigned long long id) {
+        lock_guard<mutex> lock(jobsLock);
+        size_t before = jobs.size();
+        jobs.erase(remove_if(jobs.begin(), jobs.end(),
+            [id](const serverJob& job) { return job.id == id; }), jobs.end());
+        return jobs.size() != before;
+    }
+
+    // Hands over every finished result at once
+    deque<serverResult> takeResults() {
+        lock_guard<mutex> lock(resultsLock);
+        deque<serverResult> finished;
+        finished.swap(results);
+        return finished;
+    }
+
+private:
+    const vector<lineSet>& sets;
+    int wakeFd;
+    vector<thread> threads;
+    mutex jobsLock, resultsLock;
+    condition_variable jobsReady;
+    deque<serverJob> jobs;
+    deque<serverResult> results;
+    bool stopping = false;
+
+    void work() {
+        while (true) {
+            serverJob job;
+            {
+                unique_lock<mutex> lock(jobsLock);
+                jobsReady.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (stopping) return;
+                job = move(jobs.front());
+                jobs.pop_front();
+            }
+
+            // The sets never change while we serve, so every worker can read them at the same time
+            ostringstream answers;
+            bool quit = false;
+            size_t start = 0;
+            while (start < job.commands.size() && !job.abandoned->load(memory_order_relaxed) &&
+                static_cast<size_t>(answers.tellp()) < MAX_PENDING_OUTPUT) {
+                size_t newline = job.commands.find('\n', start);
+                string command = job.commands.substr(start, newline - start);
+                start = newline + 1;
+                if (!runCommand(command, sets, *job.session, answers)) {
+                    quit = true;
+                    break;
+                }
+            }
+
+            {
+                lock_guard<mutex> lock(resultsLock);
+                results.push_back({ job.id, answers.str(), quit ? string() : job.commands.substr(start), quit });
+            }
+            unsigned long long one = 1;
+            if (write(wakeFd, &one, sizeof(one)) < 0) {
+                // The counter can't really overflow, and the loop will see the result next time anyway
+            }
+        }
+    }
+};
+
+// Event loop ids: 0 is the listening socket, 1 is the workers' eventfd, clients count up from 2
+static const unsigned long long LISTEN_ID = 0;
+static const unsigned long long WAKE_ID = 1;
+
+// Tells epoll what we want to hear about for this client right now
+static void updateInterest(int epollFd, unsigned long long id, const connection& conn) {
+    epoll_event event = {};
+    event.data.u64 = id;
+    event.events = 0;
+    if (!conn.inputClosed && conn.input.size() < MAX_PENDING_INPUT) event.events |= EPOLLIN | EPOLLRDHUP;
+    if (!conn.output.empty()) event.events |= EPOLLOUT;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, conn.fd, &event);
+}
+
+// Writes as much of the waiting answers as the socket will take
+static void flushOutput(connection& conn) {
+    while (!conn.output.empty()) {
+        ssize_t written = send(conn.fd, conn.output.data(), conn.output.size(), MSG_NOSIGNAL);
+        if (written > 0) {
+            conn.output.erase(0, written);
+        }
+        else if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        else {
+            if (written < 0 && errno != EAGAIN && errno != EWOULDBLOCK) conn.hungUp = true;
+            break;
+        }
+    }
+}
+
+// Reads everything the client has sent so far
+static void readInput(connection& conn) {
+    char buffer[16384];
+    while (conn.input.size() < MAX_PENDING_INPUT) {
+        ssize_t got = recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (got > 0) {
+            conn.input.append(buffer, got);
+        }
+        else if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        else if (got == 0) {
+            // The client is done sending, a last query without a newline still counts
+            conn.inputClosed = true;
+            if (!conn.input.empty() && conn.input.back() != '\n') conn.input += '\n';
+            break;
+        }
+        else {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) conn.hungUp = true;
+            break;
+        }
+    }
+}
+
+// Gives the client's whole queries to a worker, one batch at a time so they run in order
+static void dispatch(unsigned long long id, connection& conn, workerPool& pool) {
+    if (conn.busy || conn.quitting || conn.hungUp || conn.output.size() >= MAX_PENDING_OUTPUT) return;
+
+    // Batches are kept small, so a worker that stops early doesn't hand back a big pile of queries
+    size_t end = conn.input.rfind('\n', MAX_BATCH_INPUT);
+    if (end == string::npos) end = conn.input.find('\n');
+    if (end == string::npos) {
+        // One query longer than our whole input limit, that's not a client we can help
+        if (conn.input.size() >= MAX_PENDING_INPUT) conn.hungUp = true;
+        return;
+    }
+
+    serverJob job = { id, &conn.session, &conn.abandoned, conn.input.substr(0, end + 1) };
+    conn.input.erase(0, end + 1);
+    conn.busy = true;
+    pool.submit(move(job));
+}
+
+// Serves the sets on a Unix domain socket until Ctrl+C. Every set is analyzed once at startup,
+// the event loop does all the socket work and a pool of workers answers the queries.
+int runServer(const string& socketPath, const vector<vector<lineType>>& allLines, int workerCount) {
+    vector<lineSet> sets;
+    for (const vector<lineType>& lines : allLines) {
+        sets.push_back(lineSet(lines));
+    }
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        cerr << "Socket path is too long." << endl;
+        return 1;
+    }
+    socketPath.copy(address.sun_path, socketPath.size());
+
+    // Only clear away an old socket from a previous run, never some other file
+    struct stat existing;
+    if (stat(socketPath.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            cerr << socketPath << " already exists and isn't a socket." << endl;
+            return 1;
+        }
+        unlink(socketPath.c_str());
+    }
+
+    int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(listenFd, SOMAXCONN) < 0) {
+        cerr << "Could not listen on " << socketPath << ": " << strerror(errno) << endl;
+        if (listenFd >= 0) close(listenFd);
+        return 1;
+    }
+
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    int wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = LISTEN_ID;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+    event.data.u64 = WAKE_ID;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
+    // No SA_RESTART, so Ctrl+C interrupts epoll_wait and we get to shut down properly
+    struct sigaction stopAction = {};
+    stopAction.sa_handler = requestStop;
+    sigaction(SIGINT, &stopAction, nullptr);
+    sigaction(SIGTERM, &stopAction, nullptr);
+
+    if (workerCount < 1) workerCount = max(1u, thread::hardware_concurrency());
+    map<unsigned long long, unique_ptr<connection>> connections;
+    unsigned long long nextId = 2;
+    {
+        workerPool pool(sets, wakeFd, workerCount);
+        cerr << "Serving " << sets.size() << " sets on " << socketPath << " with "
+            << workerCount << " workers." << endl;
+
+        // Closes a client. If it hung up while its batch is still queued the batch is dropped; if a worker
+        // is already running it we stop watching the socket (or epoll keeps reporting the hangup the
+        // whole time), tell the worker to give up, and close once its result comes back.
+        auto finish = [&](unsigned long long id) {
+            connection& conn = *connections[id];
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, conn.fd, nullptr);
+            if (conn.busy) {
+                conn.abandoned = true;
+                if (!pool.cancel(id)) return;
+                conn.busy = false;
+            }
+            close(conn.fd);
+            connections.erase(id);
+        };
+
+        // After anything happens to a client: hand out queries, send answers, or say goodbye
+        auto settle = [&](unsigned long long id) {
+            connection& conn = *connections[id];
+            dispatch(id, conn, pool);
+            flushOutput(conn);
+            dispatch(id, conn, pool);    // Sending may have made room for more answers
+            bool allAnswered = !conn.busy && conn.output.empty() &&
+                (conn.quitting || (conn.inputClosed && conn.input.empty()));
+            if (conn.hungUp || allAnswered) {
+                finish(id);
+            }
+            else {
+                updateInterest(epollFd, id, conn);
+            }
+        };
+
+        epoll_event events[64];
+        while (!stopRequested) {
+            int count = epoll_wait(epollFd, events, 64, -1);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                cerr << "Event loop failed: " << strerror(errno) << endl;
+                break;
+            }
+
+            for (int e = 0; e < count; e++) {
+                unsigned long long id = events[e].data.u64;
+
+                if (id == LISTEN_ID) {
+                    int clientFd;
+                    while ((clientFd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                        unique_ptr<connection> conn(new connection());
+                        conn->fd = clientFd;
+                        epoll_event clientEvent = {};
+                        clientEvent.events = EPOLLIN | EPOLLRDHUP;
+                        clientEvent.data.u64 = nextId;
+                        epoll_ctl(epollFd, EPOLL_CTL_ADD, clientFd, &clientEvent);
+                        connections[nextId++] = move(conn);
+                    }
+                }
+                else if (id == WAKE_ID) {
+                    unsigned long long ignored;
+                    while (read(wakeFd, &ignored, sizeof(ignored)) > 0) {}
+                    for (serverResult& result : pool.takeResults()) {
+                        connection& conn = *connections[result.id];
+                        conn.busy = false;
+                        if (conn.hungUp) {
+                            finish(result.id);
+                            continue;
+                        }
+                        conn.output += result.answers;
+                        conn.input.insert(0, result.unfinished);
+                        if (result.quit) conn.quitting = true;
+                        settle(result.id);
+                    }
+                }
+                else if (connections.count(id)) {
+                    connection& conn = *connections[id];
+                    if (!conn.inputClosed && (events[e].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+                        readInput(conn);
+                    }
+                    if (events[e].events & (EPOLLERR | EPOLLHUP)) conn.hungUp = true;    // Gone both ways, nobody to answer
+                    settle(id);
+                }
+            }
+        }
+
+        cerr << "Stopping server." << endl;
+    }    // The pool stops and joins its workers here, so no session is in use after this
+
+    for (auto& entry : connections) {
+        close(entry.second->fd);
+    }
+    close(listenFd);
+    close(wakeFd);
+    close(epollFd);
+    unlink(socketPath.c_str());
+    return 0;
+}
+
+// A tiny client for trying the server out: sends everything typed (or piped) in as queries
+// and prints the answers as they come back
+int runClient(const string& socketPath) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        cerr << "Socket path is too long." << endl;
+        return 1;
+    }
+    socketPath.copy(address.sun_path, socketPath.size());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        cerr << "Could not connect to " << socketPath << ": " << strerror(errno) << endl;
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+
+    // Send and receive at the same time so a big script can't get stuck with both sides full
+    string pending;
+    bool inputDone = false;
+    bool sentAll = false;
+    char buffer[16384];
+    while (true) {
+        // A closed pipe keeps reporting POLLHUP, so stdin only goes in the list while we want to read it
+        // (poll skips an fd of -1)
+        pollfd fds[2] = { { fd, POLLIN, 0 }, { -1, 0, 0 } };
+        if (!pending.empty()) fds[0].events |= POLLOUT;
+        if (!inputDone && pending.size() < sizeof(buffer)) {
+            fds[1].fd = STDIN_FILENO;
+            fds[1].events = POLLIN;
+        }
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        if ((fds[1].events & POLLIN) && (fds[1].revents & (POLLIN | POLLHUP | POLLERR))) {
+            ssize_t got = read(STDIN_FILENO, buffer, sizeof(buffer));
+            if (got > 0) {
+                pending.append(buffer, got);
+            }
+            else {
+                inputDone = true;
+            }
+        }
+        if ((fds[0].revents & POLLOUT) && !pending.empty()) {
+            ssize_t sent = send(fd, pending.data(), pending.size(), MSG_NOSIGNAL);
+            if (sent < 0) break;
+            pending.erase(0, sent);
+        }
+        if (inputDone && pending.empty() && !sentAll) {
+            shutdown(fd, SHUT_WR);    // Lets the server know that's all the queries
+            sentAll = true;
+        }
+        if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t got = recv(fd, buffer, sizeof(buffer), 0);
+            if (got <= 0) break;
+            cout.write(buffer, got);
+            cout.flush();
+        }
+    }
+    close(fd);
+    return 0;
+}
+
+#else
+
+// Sockets and epoll are Linux things, so on Windows these just say so
+int runServer(const string&, const vector<vector<lineType>>&, int) {
+    cerr << "Server mode isn't available on Windows." << endl;
+    return 1;
+}
+
+int runClient(const string&) {
+    cerr << "Client mode isn't available on Windows." << endl;
+    return 1;
+}
+
+#endif
@@ -0,0 +1,355 @@
+#include "linetype.h"      // Our line and shape code
+#include <iostream>        // For input/output
+#include <iomanip>        // For 3 decimal places
+#include <fstream>        // For reading the file
+#include <string>         // For text manipulation
+#include <vector>         // For storing our sets
+#include <algorithm>      // For lower_bound and mismatch
+#include <chrono>         // For timing each refresh
+#include <cctype>         // For isspace
+
+#ifndef _WIN32
+#include <sys/inotify.h>  // For hearing about file changes
+#include <poll.h>         // For waiting until the writes stop
+#include <unistd.h>       // For read and close
+#include <cerrno>         // For EINTR
+#include <cstring>        // For strerror
+#include <csignal>        // For stopping cleanly on Ctrl+C
+#endif
+
+using namespace std;      // So we don't have to write std:: all the time
+
+// Reads a whole file into text, false if it can't be opened
+static bool readWholeFile(const string& path, string& text) {
+    ifstream file(path, ios::binary | ios::ate);
+    if (!file) return false;
+    streamoff size = file.tellg();
+    if (size < 0) return false;
+    text.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    file.read(&text[0], size);
+    text.resize(static_cast<size_t>(file.gcount()));
+    return true;
+}
+
+// Skips spaces and newlines
+static size_t skipSpace(const string& text, size_t pos) {
+    while (pos < text.size() && isspace(static_cast<unsigned char>(text[pos]))) pos++;
+    return pos;
+}
+
+// Two sets are the same if every coefficient matches exactly
+static bool sameLines(const vector<lineType>& first, const vector<lineType>& second) {
+    if (first.size() != second.size()) return false;
+    for (size_t i = 0; i < first.size(); i++) {
+        if (first[i].getA() != second[i].getA() || first[i].getB() != second[i].getB() ||
+            first[i].getC() != second[i].getC()) return false;
+    }
+    return true;
+}
+
+// Reads whole sets of 4 lines from source starting at pos, saving where each one starts and ends.
+// Numbers are read by readLineSet, the same as loadLineSets, so both agree on what a file means.
+// Stops at the end of the text or at something that isn't a number where a set would start; a set
+// that stops partway sets unfinished, like "Insufficient data for set." does when loading. Once we're
+// past resyncAfter it also stops as soon as a set starts exactly where an old set (from firstOldSet on)
+// started, moved over by shift: from there on the text is the same as before, and resyncSet says which
+// old set that was (-1 if we never lined up). Returns how far into source we had to look.
+size_t lineFile::parseSets(const string& source, size_t pos, size_t resyncAfter, long long shift,
+    int firstOldSet, vector<vector<lineType>>& found, vector<size_t>& starts,
+    vector<size_t>& ends, int& resyncSet, bool& unfinished) const {
+    resyncSet = -1;
+    unfinished = false;
+    vector<lineType> lines;
+    while (true) {
+        size_t start = skipSpace(source, pos);
+        if (start >= source.size()) return start;
+
+        if (start >= resyncAfter) {
+            size_t oldStart = static_cast<size_t>(static_cast<long long>(start) - shift);
+            auto match = lower_bound(setStart.begin() + firstOldSet, setStart.end(), oldStart);
+            if (match != setStart.end() && *match == oldStart) {
+                resyncSet = static_cast<int>(match - setStart.begin());
+                return start;
+            }
+        }
+
+        size_t cursor = start;
+        setReadResult result = readLineSet(source, cursor, lines);
+        if (result != setReadResult::Found) {
+            unfinished = result == setReadResult::Unfinished;
+            return start;            // Nothing after this counts
+        }
+        found.push_back(lines);
+        starts.push_back(start);
+        ends.push_back(cursor);
+        pos = cursor;
+    }
+}
+
+// Reads and analyzes the whole file, every set counts as changed
+refreshSummary lineFile::load(const string& path) {
+    refreshSummary summary;
+    filePath = path;
+    allLines.clear();
+    analyzed.clear();
+    setStart.clear();
+    setEnd.clear();
+    text.clear();
+
+    string newText;
+    if (!readWholeFile(path, newText)) {
+        summary.fileReadable = false;
+        return summary;
+    }
+    vector<vector<lineType>> found;
+    vector<size_t> starts, ends;
+    int resyncSet;
+    bool unfinished;
+    summary.bytesParsed = parseSets(newText, 0, string::npos, 0, 0, found, starts, ends, resyncSet, unfinished);
+    if (unfinished) {
+        summary.complete = false;
+        return summary;
+    }
+
+    text.swap(newText);
+    allLines.swap(found);
+    setStart.swap(starts);
+    setEnd.swap(ends);
+    for (size_t i = 0; i < allLines.size(); i++) {
+        analyzed.push_back(lineSet(allLines[i]));
+        summary.changedSets.push_back(static_cast<int>(i));
+    }
+    return summary;
+}
+
+const vector<vector<lineType>>& lineFile::lines() const { return allLines; }
+const vector<lineSet>& lineFile::sets() const { return analyzed; }
+const string& lineFile::path() const { return filePath; }
+
+// Catches up with the file. We still read all of it, but finding what changed is just comparing bytes;
+// the slow parts (turning text into numbers, classifying shapes) only happen for the changed part.
+refreshSummary lineFile::refresh() {
+    refreshSummary summary;
+    string newText;
+    if (!readWholeFile(filePath, newText)) {
+        summary.fileReadable = false;
+        return summary;
+    }
+
+    // The changed bytes are whatever is between the common start and the common end
+    size_t common = min(text.size(), newText.size());
+    size_t changeStart = mismatch(text.begin(), text.begin() + common, newText.begin()).first - text.begin();
+    if (changeStart == text.size() && changeStart == newText.size()) return summary;
+    size_t sameEnd = 0;
+    while (sameEnd < common - changeStart &&
+        text[text.size() - 1 - sameEnd] == newText[newText.size() - 1 - sameEnd]) {
+        sameEnd++;
+    }
+    long long shift = static_cast<long long>(newText.size()) - static_cast<long long>(text.size());
+    size_t changeEnd = newText.size() - sameEnd;
+
+    // Sets that end before the change can't have changed, start parsing right after the last of them
+    int first = static_cast<int>(lower_bound(setEnd.begin(), setEnd.end(), changeStart) - setEnd.begin());
+    size_t pos = first > 0 ? setEnd[first - 1] : 0;
+
+    vector<vector<lineType>> found;
+    vector<size_t> starts, ends;
+    int resyncSet;
+    bool unfinished;
+    summary.bytesParsed = parseSets(newText, pos, changeEnd, shift, first, found, starts, ends, resyncSet, unfinished) - pos;
+
+    // A set that stops partway makes the whole file bad, just like when loading it. Keep what we
+    // had, the next save will be compared against that.
+    if (unfinished) {
+        summary.complete = false;
+        return summary;
+    }
+
+    // Old sets [first, keepFrom) get replaced by what we found, the ones after that are just moved along
+    int oldCount = static_cast<int>(allLines.size());
+    int keepFrom = resyncSet >= 0 ? resyncSet : oldCount;
+    int replaced = keepFrom - first;
+    int added = static_cast<int>(found.size());
+
+    // Sets that overlap old ones: only reclassify if the lines really changed, and then only the changed lines
+    for (int k = 0; k < min(replaced, added); k++) {
+        int index = first + k;
+        if (sameLines(allLines[index], found[k])) continue;
+        if (allLines[index].size() == found[k].size()) {
+            for (size_t i = 0; i < found[k].size(); i++) {
+                if (!sameLines({ allLines[index][i] }, { found[k][i] })) {
+                    analyzed[index].replaceLine(static_cast<int>(i), found[k][i]);
+                }
+            }
+        }
+        else {
+            analyzed[index] = lineSet(found[k]);
+        }
+        allLines[index] = found[k];
+        summary.changedSets.push_back(index);
+    }
+
+    // If the number of sets changed, everything after moves to a new number
+    if (added != replaced) {
+        int tailFrom = first + min(replaced, added);
+        int tailCount = oldCount - keepFrom;
+        for (int k = 0; k < tailCount; k++) {
+            int newIndex = first + added + k;
+            if (newIndex >= oldCount || !sameLines(allLines[newIndex], allLines[keepFrom + k])) {
+                summary.changedSets.push_back(newIndex);
+            }
+        }
+        if (added > replaced) {
+            vector<lineSet> extraSets;
+            for (int k = replaced; k < added; k++) {
+                extraSets.push_back(lineSet(found[k]));
+                summary.changedSets.push_back(first + k);
+            }
+            allLines.insert(allLines.begin() + tailFrom, found.begin() + replaced, found.end());
+            analyzed.insert(analyzed.begin() + tailFrom, extraSets.begin(), extraSets.end());
+            setStart.insert(setStart.begin() + tailFrom, added - replaced, 0);
+            setEnd.insert(setEnd.begin() + tailFrom, added - replaced, 0);
+        }
+        else {
+            allLines.erase(allLines.begin() + tailFrom, allLines.begin() + keepFrom);
+            analyzed.erase(analyzed.begin() + tailFrom, analyzed.begin() + keepFrom);
+            setStart.erase(setStart.begin() + tailFrom, setStart.begin() + keepFrom);
+            setEnd.erase(setEnd.begin() + tailFrom, setEnd.begin() + keepFrom);
+        }
+        summary.removedSets = max(0, oldCount - static_cast<int>(allLines.size()));
+        sort(summary.changedSets.begin(), summary.changedSets.end());
+        summary.changedSets.erase(remove_if(summary.changedSets.begin(), summary.changedSets.end(),
+            [this](int index) { return index >= static_cast<int>(allLines.size()); }), summary.changedSets.end());
+    }
+
+    // Byte positions: the parsed sets get their new ones, the kept ones move over by shift
+    for (int k = 0; k < added; k++) {
+        setStart[first + k] = starts[k];
+        setEnd[first + k] = ends[k];
+    }
+    if (shift != 0) {
+        for (size_t k = first + added; k < setStart.size(); k++) {
+            setStart[k] += shift;
+            setEnd[k] += shift;
+        }
+    }
+
+    text.swap(newText);
+    return summary;
+}
+
+#ifndef _WIN32
+
+// Set by Ctrl+C so the watch loop can stop and main can print the adaptive counts
+static volatile sig_atomic_t stopRequested = 0;
+static void requestStop(int) { stopRequested = 1; }
+
+// Tells inotify events about our file apart from ones about its neighbours
+static bool aboutOurFile(const char* buffer, ssize_t got, const string& name) {
+    bool ours = false;
+    for (const char* at = buffer; at < buffer + got; ) {
+        const inotify_event* event = reinterpret_cast<const inotify_event*>(at);
+        if (event->len > 0 && name == event->name) ours = true;
+        at += sizeof(inotify_event) + event->len;
+    }
+    return ours;
+}
+
+// Watches the lines file and prints the sets that change every time it's saved or appended to.
+// We watch the folder rather than the file, so editors that save by replacing the file still work.
+// We look once nothing has happened to the file for a moment, so a save that empties the file and
+// writes it again is usually read whole. If we do catch it halfway, the unfinished set is left alone
+// and the last good version stays until the writer finishes.
+int runWatchMode(const string& path) {
+    const int SETTLE_MS = 50;
+    const int LONGEST_WAIT_MS = 1000;    // A writer that never stops still gets looked at this often
+
+    lineFile file;
+    refreshSummary loaded = file.load(path);
+    if (!loaded.fileReadable) {
+        cerr << "Error opening file." << endl;
+        return 1;
+    }
+    if (!loaded.complete) {
+        cerr << "Insufficient data for set." << endl;
+        return 1;
+    }
+
+    size_t slash = path.rfind('/');
+    string folder = slash == string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    string name = slash == string::npos ? path : path.substr(slash + 1);
+
+    int watchFd = inotify_init1(IN_CLOEXEC);
+    if (watchFd < 0 || inotify_add_watch(watchFd, folder.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE) < 0) {
+        cerr << "Could not watch " << folder << ": " << strerror(errno) << endl;
+        if (watchFd >= 0) close(watchFd);
+        return 1;
+    }
+
+    // No SA_RESTART, so Ctrl+C interrupts the read below and we get to stop cleanly
+    struct sigaction stopAction = {};
+    stopAction.sa_handler = requestStop;
+    sigaction(SIGINT, &stopAction, nullptr);
+    sigaction(SIGTERM, &stopAction, nullptr);
+
+    cout << "Watching " << path << ", " << file.sets().size() << " sets loaded. Press Ctrl+C to stop." << endl;
+
+    alignas(inotify_event) char buffer[8192];
+    while (!stopRequested) {
+        ssize_t got = read(watchFd, buffer, sizeof(buffer));
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        if (!aboutOurFile(buffer, got, name)) continue;
+
+        // Wait for the file to settle: keep swallowing events until it's been quiet for a bit
+        pollfd quiet = { watchFd, POLLIN, 0 };
+        auto firstEvent = chrono::steady_clock::now();
+        while (chrono::steady_clock::now() - firstEvent < chrono::milliseconds(LONGEST_WAIT_MS) &&
+            poll(&quiet, 1, SETTLE_MS) > 0) {
+            got = read(watchFd, buffer, sizeof(buffer));
+            if (got < 0 && errno != EINTR) break;
+        }
+
+        auto start = chrono::steady_clock::now();
+        refreshSummary summary = file.refresh();
+        long long micros = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+
+        if (!summary.fileReadable) {
+            cout << path << " can't be read right now, waiting for it to come back." << endl;
+            continue;
+        }
+        if (!summary.complete) {
+            cout << "Insufficient data for set, keeping the last good version until it's finished." << endl;
+            continue;
+        }
+        if (summary.changedSets.empty() && summary.removedSets == 0) continue;
+
+        for (int index : summary.changedSets) {
+            const shapeReport& report = file.sets()[index].classification();
+            cout << "Set " << (index + 1) << ": " << shapeName(report.type);
+            for (double length : report.sideLengths) {
+                cout << " " << fixed << setprecision(3) << length;
+            }
+            cout << endl;
+        }
+        if (summary.removedSets > 0) {
+            cout << summary.removedSets << " set" << (summary.removedSets == 1 ? "" : "s") << " removed, "
+                << file.sets().size() << " left." << endl;
+        }
+        cout << "Reparsed " << summary.bytesParsed << " bytes in " << micros << " us." << endl;
+    }
+
+    close(watchFd);
+    return 0;
+}
+
+#else
+
+// inotify is a Linux thing, so on Windows this just says so
+int runWatchMode(const string&) {
+    cerr << "Watch mode isn't available on Windows." << endl;
+    return 1;
+}
+
+#endif